@@ -0,0 +1,291 @@
+﻿// Copyright (c) 2021 Cvelth <cvelth.mail@gmail.com>
+// SPDX-License-Identifier: MIT
+
+// Synthesizes doxygen xml corpora of growing size and measures 'parse' + 'generate' + save.
+//
+// Usage: benchmark [--scale N]... [--directory PATH] [--verbose] [--structs N] [--enums N]
+//                  [--enumerators N] [--functions N] [--pfns N] [--handles N] [--depth N]
+//
+// Counts describe the 1x corpus (roughly 'vulkan_core.h'-sized) and are multiplied by every
+// '--scale' (1, 10 and 100 by default).
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef _WIN32
+  #define NOMINMAX
+  #include <windows.h>
+
+  #include <psapi.h>
+#else
+  #include <sys/resource.h>
+#endif
+
+#include "generator.hpp"
+using namespace std::literals;
+
+struct corpus_config_t {
+  size_t structs = 1000;
+  size_t enums = 350;
+  size_t enumerators = 10;
+  size_t functions = 700;
+  size_t pfns = 80;
+  size_t handles = 50;
+  size_t depth = 4; // Length of struct-to-struct member chains.
+};
+
+static size_t peak_rss() {
+#ifdef _WIN32
+  PROCESS_MEMORY_COUNTERS counters;
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    return counters.PeakWorkingSetSize;
+  return 0;
+#else
+  rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage))
+    return 0;
+  #ifdef __APPLE__
+  return static_cast<size_t>(usage.ru_maxrss);
+  #else
+  return static_cast<size_t>(usage.ru_maxrss) * 1024;
+  #endif
+#endif
+}
+
+static size_t write_file(std::filesystem::path const &path, std::string const &content) {
+  std::ofstream(path, std::ios::binary).write(content.data(), content.size());
+  return content.size();
+}
+
+static std::string compound(std::string_view kind, std::string_view id, std::string_view body) {
+  std::string output = "<?xml version='1.0' encoding='UTF-8' standalone='no'?>\n<doxygen>";
+  ((((output += "<compounddef id=\"") += id) += "\" kind=\"") += kind) += "\">";
+  output += body;
+  return output += "</compounddef></doxygen>\n";
+}
+static void append_member(std::string &output, std::string_view kind,
+                          std::initializer_list<std::pair<std::string_view, std::string>> children,
+                          std::string_view extra = "") {
+  ((output += "<memberdef kind=\"") += kind) += "\">";
+  for (auto const &[tag, value] : children)
+    ((((((output += '<') += tag) += '>') += value) += "</") += tag) += '>';
+  (output += extra) += "</memberdef>";
+}
+
+struct corpus_t {
+  std::filesystem::path xml_directory;
+  std::vector<std::filesystem::path> header_files;
+  size_t entities = 0;
+  size_t bytes = 0;
+};
+
+static corpus_t synthesize(std::filesystem::path const &directory, corpus_config_t const &config) {
+  corpus_t output;
+  output.xml_directory = directory / "xml";
+  std::filesystem::remove_all(directory);
+  std::filesystem::create_directories(output.xml_directory);
+
+  std::string index = "<?xml version='1.0' encoding='UTF-8' standalone='no'?>\n<doxygenindex>";
+  auto add_to_index = [&index](std::string_view id, std::string_view kind) {
+    ((((index += "<compound refid=\"") += id) += "\" kind=\"") += kind) += "\"/>";
+  };
+
+  auto handle_name = [&config](size_t i) { return "VkbHandle" + std::to_string(i % config.handles); };
+  auto struct_name = [](size_t i) { return "VkbStruct" + std::to_string(i); };
+
+  // Handles come from a header, the same way 'vkma_bindings.hpp' provides them.
+  std::string header = "#pragma once\n";
+  for (size_t i = 0; i < config.handles; ++i)
+    ((((header += i % 4 ? "VK_DEFINE_NON_DISPATCHABLE_HANDLE(" : "VK_DEFINE_HANDLE(")
+       += handle_name(i))
+      += ") // parent: ")
+      += i ? handle_name((i - 1) / 2) : "none"s)
+      += '\n';
+  output.header_files.emplace_back(directory / "bench.h");
+  output.bytes += write_file(output.header_files.back(), header);
+  output.entities += config.handles;
+
+  for (size_t i = 0; i < config.structs; ++i) {
+    std::string body = "<compoundname>" + struct_name(i) + "</compoundname>"
+                       + "<sectiondef kind=\"public-attrib\">";
+    append_member(body, "variable", { { "type", "VkbStructureType" }, { "name", "sType" } },
+                  "<argsstring></argsstring>");
+    append_member(body, "variable", { { "type", "const void *" }, { "name", "pNext" } },
+                  "<argsstring></argsstring>");
+    append_member(body, "variable", { { "type", handle_name(i) }, { "name", "handle" } },
+                  "<argsstring></argsstring>");
+    append_member(body, "variable", { { "type", "uint32_t" }, { "name", "count" } },
+                  "<argsstring></argsstring>");
+    append_member(body, "variable", { { "type", "float" }, { "name", "values" } },
+                  "<argsstring>[VKB_MAX_VALUES]</argsstring>");
+    if (config.depth > 1 && i % config.depth)
+      append_member(body, "variable", { { "type", struct_name(i - 1) }, { "name", "next" } },
+                    "<argsstring></argsstring>");
+    body += "</sectiondef>";
+
+    auto id = "struct_vkb_struct" + std::to_string(i);
+    output.bytes += write_file(output.xml_directory / (id + ".xml"),
+                               compound("struct", id, body));
+    add_to_index(id, "struct");
+  }
+  output.entities += config.structs;
+
+  // File members are split into 'vulkan_core.h'-sized files.
+  constexpr size_t members_per_file = 1000;
+  std::string body;
+  size_t file_count = 0, member_count = 0;
+  auto flush = [&](bool force) {
+    if (member_count && (force || member_count >= members_per_file)) {
+      auto id = "bench_" + std::to_string(file_count++) + "_8h";
+      output.bytes += write_file(output.xml_directory / (id + ".xml"),
+                                 compound("file", id, "<sectiondef kind=\"func\">" + body
+                                                        + "</sectiondef>"));
+      add_to_index(id, "file");
+      body.clear();
+      member_count = 0;
+    }
+  };
+  auto add_member = [&](std::string_view kind,
+                        std::initializer_list<std::pair<std::string_view, std::string>> children,
+                        std::string_view extra = "") {
+    append_member(body, kind, children, extra);
+    ++member_count;
+    ++output.entities;
+    flush(false);
+  };
+
+  add_member("define", { { "name", "VKB_MAX_VALUES"s }, { "initializer", "16U"s } });
+  add_member("typedef", { { "type", "uint32_t"s }, { "name", "VkFlags"s }, { "argsstring", ""s } });
+  std::string enumerators;
+  for (size_t i = 0; i < config.structs; ++i)
+    enumerators += "<enumvalue><name>VKB_STRUCTURE_TYPE_" + std::to_string(i)
+                   + "</name><initializer>= " + std::to_string(i) + "</initializer></enumvalue>";
+  add_member("enum", { { "type", ""s }, { "name", "VkbStructureType"s } }, enumerators);
+  add_member("enum", { { "type", ""s }, { "name", "VkResult"s } },
+             "<enumvalue><name>VK_SUCCESS</name><initializer>= 0</initializer></enumvalue>"
+             "<enumvalue><name>VK_ERROR_UNKNOWN</name><initializer>= -13</initializer>"
+             "</enumvalue>");
+
+  for (size_t i = 0; i < config.enums; ++i) {
+    bool const is_bitmask = i % 3 == 0;
+    auto name = "VkbEnum" + std::to_string(i) + (is_bitmask ? "FlagBits" : "");
+    enumerators.clear();
+    for (size_t j = 0; j < config.enumerators; ++j) {
+      auto value = is_bitmask ? "0x" + (std::ostringstream{} << std::hex << (1u << (j % 31))).str()
+                              : std::to_string(j);
+      enumerators += "<enumvalue><name>VKB_ENUM_" + std::to_string(i) + "_VALUE_"
+                     + std::to_string(j) + "</name><initializer>= " + value
+                     + "</initializer></enumvalue>";
+    }
+    add_member("enum", { { "type", ""s }, { "name", name } }, enumerators);
+    if (is_bitmask)
+      add_member("typedef", { { "type", "VkFlags"s },
+                              { "name", "VkbEnum" + std::to_string(i) + "Flags" },
+                              { "argsstring", ""s } });
+  }
+
+  for (size_t i = 0; i < config.pfns; ++i)
+    add_member("typedef", { { "type", "void(*"s },
+                            { "name", "PFN_vkbCallback" + std::to_string(i) },
+                            { "argsstring", ")(" + handle_name(i) + " handle, void *pUserData)" } });
+
+  for (size_t i = 0; i < config.functions; ++i)
+    add_member("function", { { "type", "VkResult"s }, { "name", "vkbFunction" + std::to_string(i) } },
+               "<param><type>" + handle_name(i) + "</type><declname>handle</declname></param>"
+                 + "<param><type>const " + struct_name(i % config.structs)
+                 + " *</type><declname>pInfo</declname></param>"
+                 + "<param><type>" + handle_name(i + 1)
+                 + " *</type><declname>pOutput</declname></param>");
+  flush(true);
+
+  index += "</doxygenindex>\n";
+  output.bytes += write_file(output.xml_directory / "index.xml", index);
+  return output;
+}
+
+int main(int argc, char **argv) {
+  corpus_config_t config;
+  std::vector<size_t> scales;
+  bool verbose = false;
+  std::filesystem::path directory = std::filesystem::temp_directory_path() / "vkma_benchmark";
+  for (int i = 1; i < argc; ++i)
+    if (i + 1 < argc && argv[i] == "--scale"sv)
+      scales.emplace_back(std::stoull(argv[++i]));
+    else if (i + 1 < argc && argv[i] == "--directory"sv)
+      directory = argv[++i];
+    else if (argv[i] == "--verbose"sv)
+      verbose = true;
+    else if (i + 1 < argc && argv[i] == "--structs"sv)
+      config.structs = std::stoull(argv[++i]);
+    else if (i + 1 < argc && argv[i] == "--enums"sv)
+      config.enums = std::stoull(argv[++i]);
+    else if (i + 1 < argc && argv[i] == "--enumerators"sv)
+      config.enumerators = std::stoull(argv[++i]);
+    else if (i + 1 < argc && argv[i] == "--functions"sv)
+      config.functions = std::stoull(argv[++i]);
+    else if (i + 1 < argc && argv[i] == "--pfns"sv)
+      config.pfns = std::stoull(argv[++i]);
+    else if (i + 1 < argc && argv[i] == "--handles"sv)
+      config.handles = std::max<size_t>(std::stoull(argv[++i]), 1);
+    else if (i + 1 < argc && argv[i] == "--depth"sv)
+      config.depth = std::stoull(argv[++i]);
+    else
+      std::cout << "Warning: Ignore an unknown argument: '" << argv[i] << "'.\n";
+  if (scales.empty())
+    scales = { 1, 10, 100 };
+  config.structs = std::max<size_t>(config.structs, 1);
+
+  std::cout << std::setw(6) << "scale" << std::setw(10) << "entities" << std::setw(10) << "input"
+            << std::setw(10) << "parse" << std::setw(10) << "generate" << std::setw(10) << "save"
+            << std::setw(14) << "entities/s" << std::setw(10) << "MB/s" << std::setw(12)
+            << "peak RSS" << "\n";
+  for (auto scale : scales) {
+    auto scaled = config;
+    for (auto *count : { &scaled.structs, &scaled.enums, &scaled.functions, &scaled.pfns,
+                         &scaled.handles })
+      *count *= scale;
+    auto corpus = synthesize(directory / ("x" + std::to_string(scale)), scaled);
+
+    // The generator reports every step to 'std::cout': keep the table readable.
+    std::ostringstream log;
+    auto *original_buffer = verbose ? std::cout.rdbuf() : std::cout.rdbuf(log.rdbuf());
+
+    auto start = std::chrono::steady_clock::now();
+    auto api = vkma_xml::parse(
+      vkma_xml::input{ .xml_directory = corpus.xml_directory, .header_files = corpus.header_files });
+    auto parsed = std::chrono::steady_clock::now();
+    auto output = api ? vkma_xml::generate(*api) : std::nullopt;
+    auto generated = std::chrono::steady_clock::now();
+    bool const saved = output && output->save_file((directory / "vkma.xml").c_str());
+    auto finish = std::chrono::steady_clock::now();
+
+    std::cout.rdbuf(original_buffer);
+    if (!saved) {
+      std::cout << "Error: Benchmark at scale " << scale << " failed:\n" << log.str();
+      return 1;
+    }
+
+    auto seconds = [](auto duration) {
+      return std::chrono::duration_cast<std::chrono::duration<double>>(duration).count();
+    };
+    double const total = seconds(finish - start);
+    std::cout << std::fixed << std::setprecision(3) << std::setw(5) << scale << "x"
+              << std::setw(10) << corpus.entities << std::setw(8)
+              << corpus.bytes / 1048576.0 << "MB" << std::setw(9) << seconds(parsed - start)
+              << "s" << std::setw(9) << seconds(generated - parsed) << "s" << std::setw(9)
+              << seconds(finish - generated) << "s" << std::setw(14) << std::setprecision(0)
+              << corpus.entities / total << std::setw(10) << std::setprecision(2)
+              << corpus.bytes / 1048576.0 / total << std::setw(10) << peak_rss() / 1048576
+              << "MB" << std::endl;
+  }
+  // Peak RSS only grows within a process: run scales in ascending order to attribute it.
+  return 0;
+}
@@ -0,0 +1,147 @@
+// Copyright (c) 2021 Cvelth <cvelth.mail@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "emitter.hpp"
+#include "generator.hpp"
+
+namespace vkma_xml {
+  // Runs a job on some thread, sooner or later. A job it never gets to is fine as long as it is
+  // destroyed eventually: the workers a call asks for are only an offer to help.
+  using executor_t = std::function<void(std::function<void()> &&)>;
+
+  // How an embedder drives one asynchronous call. Callbacks are never called concurrently.
+  struct run_options_t {
+    // Runs the call itself and the workers it asks for. If empty, on a pool of a thread per
+    // core shared by the whole process, made on first use and joined once the program exits.
+    // Bound the concurrency of a call by bounding the executor.
+    executor_t executor;
+
+    // Warnings, errors and summaries, one complete message per call, without the trailing
+    // line break. Printed to 'std::cout' if empty.
+    std::function<void(std::string_view)> on_message;
+    // The name of a finished step, how many steps of the current stage are done and out of how
+    // many. Parsing and generating are a stage each.
+    std::function<void(std::string_view, size_t, size_t)> on_progress;
+
+    // Once a stop is requested, the steps that have not started yet are skipped and the result
+    // is 'std::nullopt' / 'false'. Generation stops between its passes, leaving the emitters
+    // incomplete: do not save them.
+    std::stop_token stop_token;
+  };
+
+  // The inputs are copied, the call does not refer to them once it returns.
+  std::future<std::optional<detail::api_t>>
+  parse_async(input main_api, std::vector<input> const &helper_apis, run_options_t options);
+  std::future<std::optional<detail::api_t>>
+  parse_headers_async(input main_api, std::vector<input> const &helper_apis,
+                      run_options_t options);
+
+  // 'api' and 'emitters' have to outlive the returned future. 'false' if it was stopped, the
+  // emitters are incomplete then.
+  std::future<bool> generate_async(detail::api_t const &api,
+                                   std::vector<detail::emitter_t *> emitters,
+                                   std::vector<std::string> roots, run_options_t options);
+
+  namespace detail {
+    // The call the current thread works for, if any. Only the outermost task graph of a call
+    // reports its progress.
+    struct run_context_t {
+      run_options_t const &options;
+      std::mutex &callback_mutex;
+      bool reports_progress = true;
+      // Keeps 'options' and 'callback_mutex' alive for the copies that outlive the call.
+      std::shared_ptr<void const> owner = nullptr;
+    };
+    inline thread_local run_context_t const *current_run = nullptr;
+
+    // Makes the current thread work for 'context' for as long as it is alive. Does nothing for
+    // 'nullptr'.
+    class run_scope_t {
+    public:
+      run_scope_t(run_context_t const *context);
+      run_scope_t(run_scope_t const &) = delete;
+      run_scope_t &operator=(run_scope_t const &) = delete;
+      ~run_scope_t();
+
+    protected:
+      run_context_t const *previous;
+    };
+
+    // Runs 'job' with the executor of the current call.
+    void execute(std::function<void()> &&job);
+    bool is_stop_requested();
+    // For the steps that do not run on a task graph.
+    void report_progress(std::string_view step, size_t done, size_t total);
+
+    // 'decoder', reporting to the current call whenever and on whatever thread it runs, even
+    // once the call has returned. It never reports progress.
+    template <typename decoder_t>
+    auto bind_current_run(decoder_t &&decoder) {
+      std::optional<run_context_t> context;
+      if (current_run && current_run->owner)
+        context.emplace(run_context_t{ current_run->options, current_run->callback_mutex, false,
+                                       current_run->owner });
+      return [context = std::move(context), decoder = std::forward<decoder_t>(decoder)] {
+        run_scope_t scope(context ? &*context : nullptr);
+        return decoder();
+      };
+    }
+
+    // Collects one message and hands it over once destroyed, so that the messages of concurrent
+    // workers never interleave. Use 'message() << ...;' for a single line.
+    class message_t {
+    public:
+      message_t() = default;
+      message_t(message_t const &) = delete;
+      message_t &operator=(message_t const &) = delete;
+      ~message_t();
+
+      template <typename T>
+      message_t &operator<<(T const &value) {
+        stream << value;
+        return *this;
+      }
+
+    protected:
+      std::ostringstream stream;
+    };
+    inline message_t message() { return {}; }
+
+    // Messages held back, so that steps running concurrently report in a fixed order rather
+    // than in the order they happen to run in. A 'capture_t' redirects the messages of the
+    // current thread into the buffer for as long as it is alive.
+    class message_buffer_t {
+    public:
+      class capture_t {
+      public:
+        capture_t(message_buffer_t &buffer);
+        capture_t(capture_t const &) = delete;
+        capture_t &operator=(capture_t const &) = delete;
+        ~capture_t();
+
+      protected:
+        message_buffer_t *previous;
+      };
+
+      // Hands the messages over, in the order they were made, as if they were made now.
+      void flush();
+
+    protected:
+      friend class message_t;
+      std::vector<std::string> messages;
+    };
+  } // namespace detail
+} // namespace vkma_xml
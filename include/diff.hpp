@@ -0,0 +1,52 @@
+// Copyright (c) 2021 Cvelth <cvelth.mail@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "generator.hpp"
+#include "query.hpp"
+
+namespace vkma_xml {
+  // Structural hashes of every registry entry. 'own' covers the definition of an entry alone,
+  // 'total' also covers the 'total' of everything it depends on, so two entries with equal
+  // 'total' hashes are equal together with their whole dependency tree.
+  // Mutually dependent entries share one 'total', computed over the whole cycle.
+  class merkle_t {
+  public:
+    merkle_t(query_t const &query);
+
+    std::uint64_t own(query_t::entry_t const &entry) const { return owns[entry.second.index]; }
+    std::uint64_t total(query_t::entry_t const &entry) const {
+      return totals[entry.second.index];
+    }
+    // Entries of one dependency cycle share a component, every other entry has its own.
+    size_t component(query_t::entry_t const &entry) const {
+      return components[entry.second.index];
+    }
+
+  protected:
+    std::vector<std::uint64_t> owns;
+    std::vector<std::uint64_t> totals;
+    std::vector<size_t> components;
+  };
+
+  struct diff_t {
+    std::vector<std::string> added;
+    std::vector<std::string> removed;
+    std::vector<std::string> changed; // Their own definition differs.
+    size_t compared = 0;              // Entries present on both sides that had to be visited.
+  };
+
+  // Walks both registries from the entries nothing else refers to and only descends into
+  // the dependencies of an entry when its 'total' hash differs, so the walk costs the number of
+  // roots plus the size of the change. Building the query and the hashes of an api is linear in
+  // its size: to compare one api with several others, build them once and use the overload.
+  diff_t diff(detail::api_t const &before, detail::api_t const &after);
+  diff_t diff(query_t const &before_query, merkle_t const &before_hashes,
+              query_t const &after_query, merkle_t const &after_hashes);
+} // namespace vkma_xml
@@ -0,0 +1,224 @@
+// Copyright (c) 2021 Cvelth <cvelth.mail@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "generator.hpp"
+#include "pugixml.hpp"
+
+namespace vkma_xml {
+  namespace detail {
+    // Receives the registry from 'generator_t' one element at a time, in the output order.
+    // Categories follow 'vk.xml' naming. Each implementation owns its encoding.
+    class emitter_t {
+    public:
+      virtual ~emitter_t() = default;
+
+      virtual void begin() = 0;
+      virtual void end() = 0;
+
+      virtual void begin_types() = 0;
+      // 'keyword' is either "struct", "union", "enum" or empty for an opaque name.
+      virtual void append_basetype(std::string_view keyword, std::string_view name) = 0;
+      virtual void append_typedef(std::string_view name, decorated_typename_t const &type) = 0;
+      // 'VkFlags64' rather than 'VkFlags' if 'is_64bit'.
+      virtual void append_bitmask(std::string_view name, std::optional<std::string_view> bits,
+                                  bool is_64bit) = 0;
+      virtual void append_define(std::string_view name, std::string_view value) = 0;
+      virtual void append_enum_type(std::string_view name) = 0;
+      virtual void append_handle(std::string_view name, type::handle const &handle,
+                                 std::string_view objtypeenum) = 0;
+      virtual void append_struct(std::string_view name, type::structure const &structure) = 0;
+      virtual void append_funcpointer(std::string_view name,
+                                      type::function_pointer const &function_pointer) = 0;
+
+      virtual void begin_enumerations() = 0;
+      virtual void append_constant(std::string_view name, std::string_view value) = 0;
+      virtual void append_enumeration(std::string_view name, type::enumeration const &enumeration,
+                                      bool is_bitmask, bool is_64bit) = 0;
+
+      virtual void begin_commands() = 0;
+      virtual void append_command(std::string_view name, type::function const &function,
+                                  std::string_view success_codes,
+                                  std::string_view error_codes) = 0;
+
+      virtual void append_feature(appended_set_t const &types,
+                                  appended_set_t const &commands) = 0;
+
+      virtual bool save(std::filesystem::path const &path) const = 0;
+
+      // The top level entry the elements that follow are emitted for, either directly or as one
+      // of its dependencies.
+      virtual void begin_root(std::string_view) {}
+    };
+
+    // 'vk.xml'-compatible registry, as expected by the vulkan-hpp generator.
+    class xml_emitter_t : public emitter_t {
+    public:
+      static void append_typename(pugi::xml_node &xml, decorated_typename_t const &type);
+
+      xml_emitter_t();
+
+      void begin() override;
+      void end() override;
+
+      void begin_types() override;
+      void append_basetype(std::string_view keyword, std::string_view name) override;
+      void append_typedef(std::string_view name, decorated_typename_t const &type) override;
+      void append_bitmask(std::string_view name, std::optional<std::string_view> bits,
+                          bool is_64bit) override;
+      void append_define(std::string_view name, std::string_view value) override;
+      void append_enum_type(std::string_view name) override;
+      void append_handle(std::string_view name, type::handle const &handle,
+                         std::string_view objtypeenum) override;
+      void append_struct(std::string_view name, type::structure const &structure) override;
+      void append_funcpointer(std::string_view name,
+                              type::function_pointer const &function_pointer) override;
+
+      void begin_enumerations() override;
+      void append_constant(std::string_view name, std::string_view value) override;
+      void append_enumeration(std::string_view name, type::enumeration const &enumeration,
+                              bool is_bitmask, bool is_64bit) override;
+
+      void begin_commands() override;
+      void append_command(std::string_view name, type::function const &function,
+                          std::string_view success_codes, std::string_view error_codes) override;
+
+      void append_feature(appended_set_t const &types, appended_set_t const &commands) override;
+
+      bool save(std::filesystem::path const &path) const override;
+
+    public:
+      std::optional<pugi::xml_document> output;
+      pugi::xml_node registry;
+      pugi::xml_node types;
+      pugi::xml_node constants;
+      pugi::xml_node commands;
+    };
+
+    // Streams an upstream 'vk.xml' through and splices the registry into its sections on the way:
+    // types, 'API Constants', enums, commands and the feature. The upstream file is never loaded
+    // into a DOM. The placeholder platforms, tags and extensions of 'xml_emitter_t' are left out.
+    class merge_emitter_t : public xml_emitter_t {
+    public:
+      merge_emitter_t(std::filesystem::path upstream) : upstream(std::move(upstream)) {}
+
+      bool save(std::filesystem::path const &path) const override;
+
+    public:
+      std::filesystem::path upstream;
+    };
+
+    // Records which top level entry first pulled each element into the output and how large the
+    // element is in 'vk.xml'. 'save' writes a report: every root with the size of its whole
+    // dependency closure and of the part it pulled in first, then every element.
+    class explain_emitter_t : public xml_emitter_t {
+    public:
+      struct record_t {
+        std::string name;
+        std::string_view category;
+        std::string root;
+        size_t nodes;
+        size_t bytes;
+      };
+
+      explain_emitter_t(api_t const &api) : api(api) {}
+
+      void begin_root(std::string_view name) override { root = name; }
+
+      void append_basetype(std::string_view keyword, std::string_view name) override;
+      void append_typedef(std::string_view name, decorated_typename_t const &type) override;
+      void append_bitmask(std::string_view name, std::optional<std::string_view> bits,
+                          bool is_64bit) override;
+      void append_define(std::string_view name, std::string_view value) override;
+      void append_enum_type(std::string_view name) override;
+      void append_handle(std::string_view name, type::handle const &handle,
+                         std::string_view objtypeenum) override;
+      void append_struct(std::string_view name, type::structure const &structure) override;
+      void append_funcpointer(std::string_view name,
+                              type::function_pointer const &function_pointer) override;
+
+      void append_constant(std::string_view name, std::string_view value) override;
+      void append_enumeration(std::string_view name, type::enumeration const &enumeration,
+                              bool is_bitmask, bool is_64bit) override;
+
+      void append_command(std::string_view name, type::function const &function,
+                          std::string_view success_codes, std::string_view error_codes) override;
+
+      bool save(std::filesystem::path const &path) const override;
+
+    public:
+      api_t const &api;
+      std::vector<record_t> records; // In the output order.
+
+    protected:
+      void record(std::string_view name, std::string_view category, pugi::xml_node const &node,
+                  std::string_view pulled_by);
+
+    protected:
+      std::string root;
+      transparent_map<size_t> indices;     // Position in 'records' of every element.
+      transparent_map<std::string> arrays; // Root of the first struct using each array size.
+    };
+
+    // The same registry as a single json object, for consumers that do not want an xml parser:
+    // { "types": [...], "constants": [...], "enums": [...], "commands": [...], "feature": {...} }
+    // Every element carries the 'category' / attribute names the xml uses.
+    class json_emitter_t : public emitter_t {
+    public:
+      void begin() override;
+      void end() override;
+
+      void begin_types() override {}
+      void append_basetype(std::string_view keyword, std::string_view name) override;
+      void append_typedef(std::string_view name, decorated_typename_t const &type) override;
+      void append_bitmask(std::string_view name, std::optional<std::string_view> bits,
+                          bool is_64bit) override;
+      void append_define(std::string_view name, std::string_view value) override;
+      void append_enum_type(std::string_view name) override;
+      void append_handle(std::string_view name, type::handle const &handle,
+                         std::string_view objtypeenum) override;
+      void append_struct(std::string_view name, type::structure const &structure) override;
+      void append_funcpointer(std::string_view name,
+                              type::function_pointer const &function_pointer) override;
+
+      void begin_enumerations() override {}
+      void append_constant(std::string_view name, std::string_view value) override;
+      void append_enumeration(std::string_view name, type::enumeration const &enumeration,
+                              bool is_bitmask, bool is_64bit) override;
+
+      void begin_commands() override {}
+      void append_command(std::string_view name, type::function const &function,
+                          std::string_view success_codes, std::string_view error_codes) override;
+
+      void append_feature(appended_set_t const &types, appended_set_t const &commands) override;
+
+      bool save(std::filesystem::path const &path) const override;
+
+    public:
+      std::string output; // Complete after 'end()'.
+
+    protected:
+      std::string types;
+      std::string constants;
+      std::string enums;
+      std::string commands;
+      std::string feature;
+
+      std::vector<std::string> typenames; // Rendered once per 'decorated_typename_t::id()'.
+    };
+  } // namespace detail
+
+  // Runs the generator once, feeding every emitter. See 'generate' in "generator.hpp".
+  // The passes run one after another on the calling thread: every one of them extends the sets
+  // of appended entities the next one reads, and the emitters take the output in order.
+  // 'false' if the current call was stopped before the last pass, the emitters are incomplete.
+  bool generate(detail::api_t const &api, std::vector<detail::emitter_t *> const &emitters,
+                std::vector<std::string_view> const &roots);
+} // namespace vkma_xml
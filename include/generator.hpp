@@ -3,48 +3,109 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
 #include <concepts>
+#include <condition_variable>
+#include <cstdint>
 #include <filesystem>
+#include <functional>
 #include <initializer_list>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <set>
+#include <string_view>
+#include <thread>
 #include <type_traits>
 #include <unordered_map>
-#include <unordered_set>
 #include <variant>
 #include <vector>
 
 #include "pugixml.hpp"
 
 namespace vkma_xml {
+  // The main api is always core: everything it defines is emitted in full. Helpers only provide
+  // what it refers to, as forward declarations, unless they are core as well.
+  //
+  // Scale target, for a whole C API the size of Vulkan (~100x 'output/vkma.xml') as core: on a
+  // single core, parse under 0.5s, generate under 0.2s, save under 0.2s and 150MB peak memory.
+  // A synthetic 23k entry api (four times that) currently takes 0.45s, 0.13s, 0.17s and 147MB.
   struct input {
     std::filesystem::path const &xml_directory;
     std::vector<std::filesystem::path> const &header_files;
+    bool is_core = false;
   };
   namespace detail {
     template <typename T>
     concept parser_input = std::is_same<T, input>::value;
     using transparent_set = std::set<std::string, std::less<>>;
 
+    struct transparent_comparator_t : std::equal_to<> {
+      using is_transparent = void;
+    };
+    struct transparent_hash_t {
+      using is_transparent = transparent_comparator_t::is_transparent;
+      using transparent_key_equal = transparent_comparator_t;
+      size_t operator()(std::string_view txt) const { return std::hash<std::string_view>{}(txt); }
+      size_t operator()(std::string const &txt) const { return std::hash<std::string_view>{}(txt); }
+      size_t operator()(char const *txt) const { return std::hash<std::string_view>{}(txt); }
+    };
+    template <typename value_t>
+    using transparent_map
+      = std::unordered_map<std::string, value_t, transparent_hash_t, transparent_comparator_t>;
+
     using identifier_t = std::string;
     using value_t = std::string;
-    struct decorated_typename_t {
+    // One canonical (prefix, name, postfix) triple, destroyed with the table it is interned in.
+    // Ids are only unique within a table.
+    struct typename_entry_t {
       std::string prefix;
       identifier_t name;
       std::string postfix;
+      std::string spelling; // 'prefix + name + postfix'.
+      std::uint32_t id;     // Dense, 0 is the empty type.
+    };
+    // Every 'api_t' alive at the same time shares one table of decorated types, freed with the
+    // last of them and of the types interned in it. Types made while no api is alive go to the
+    // table the next api takes over.
+    class typename_table_t;
+    std::shared_ptr<typename_table_t> share_typenames();
 
-      decorated_typename_t() = default;
+    // A hash-consed reference: equal types share one 'typename_entry_t', so comparing two of them
+    // is a pointer compare and the strings are stored once. It keeps its table alive.
+    class decorated_typename_t {
+    public:
+      decorated_typename_t();
       decorated_typename_t(std::string input);
-      operator std::string() const { return prefix + name + postfix; }
-      operator bool() const { return !name.empty(); }
-      bool operator!() const { return name.empty(); }
+
+      std::string const &prefix() const { return entry->prefix; }
+      identifier_t const &name() const { return entry->name; }
+      std::string const &postfix() const { return entry->postfix; }
+      std::string const &spelling() const { return entry->spelling; }
+      std::uint32_t id() const { return entry->id; }
+
+      operator std::string() const { return entry->spelling; }
+      operator bool() const { return !entry->name.empty(); }
+      bool operator!() const { return entry->name.empty(); }
+      bool operator==(decorated_typename_t const &another) const {
+        return entry.get() == another.entry.get();
+      }
 
       auto to_string() const { return std::string(*this); }
+
+      // The number of distinct types in the current table, the empty one included.
+      static size_t count();
+
+    private:
+      std::shared_ptr<typename_entry_t const> entry; // Owns the table, not just the entry.
     };
     inline std::ostream &operator<<(std::ostream &stream, decorated_typename_t const &type) {
-      return stream << type.prefix << type.name << type.postfix;
+      return stream << type.spelling();
     }
 
     struct variable_t {
@@ -54,19 +115,77 @@ namespace vkma_xml {
 
       variable_t(identifier_t name, decorated_typename_t type,
                  std::optional<identifier_t> array = std::nullopt)
-        : name(name), type(type), array(array) {}
+        : name(std::move(name)), type(std::move(type)), array(std::move(array)) {}
     };
     struct constant_t {
       identifier_t name;
       value_t value;
+      std::optional<std::int64_t> number; // 'value' folded at parse time, if it is constant.
 
-      constant_t(identifier_t name, value_t value) : name(name), value(value) {}
+      constant_t(identifier_t name, value_t value,
+                 std::optional<std::int64_t> number = std::nullopt)
+        : name(std::move(name)), value(std::move(value)), number(number) {}
+    };
+
+    // A value decoded from its source on the first access, at most once even if several
+    // threads ask at the same time. Copies share both the source and the decoded value.
+    template <typename value_t>
+    class lazy_t {
+    public:
+      using decoder_t = std::function<value_t()>;
+
+      lazy_t() : lazy_t(value_t{}) {}
+      lazy_t(value_t value) : state(std::make_shared<state_t>()) {
+        state->value = std::move(value);
+        state->decoded = true;
+      }
+      template <typename function_t>
+        requires std::is_invocable_r_v<value_t, function_t>
+      lazy_t(function_t decoder) : state(std::make_shared<state_t>()) {
+        state->decoder = std::move(decoder);
+      }
+
+      inline value_t const &operator*() const { return decode(); }
+      inline value_t const *operator->() const { return &decode(); }
+      inline bool is_decoded() const { return state->decoded; }
+
+    protected:
+      value_t const &decode() const {
+        std::call_once(state->once, [this] {
+          if (!state->decoded) {
+            state->value = state->decoder();
+            state->decoder = nullptr; // Releases the source.
+            state->decoded = true;
+          }
+        });
+        return state->value;
+      }
+
+    protected:
+      struct state_t {
+        std::once_flag once;
+        std::atomic<bool> decoded = false;
+        decoder_t decoder;
+        value_t value;
+      };
+      std::shared_ptr<state_t> state;
+    };
+
+    // A part of a text shared by everything decoded from it, in place of a copy of each part.
+    struct source_slice_t {
+      std::shared_ptr<std::string const> text;
+      size_t offset;
+      size_t size;
+
+      inline std::string_view view() const { return std::string_view(*text).substr(offset, size); }
     };
 
     namespace type {
       struct undefined {};
       struct structure {
-        std::vector<variable_t> members;
+        // Undecoded for helper structs until something looks inside them.
+        lazy_t<std::vector<variable_t>> members;
+        bool is_union = false;
       };
       struct handle {
         bool dispatchable;
@@ -82,7 +201,7 @@ namespace vkma_xml {
       };
       struct function {
         decorated_typename_t return_type;
-        std::vector<variable_t> parameters;
+        lazy_t<std::vector<variable_t>> parameters; // Undecoded for helper functions.
       };
       struct function_pointer {
         decorated_typename_t return_type;
@@ -101,11 +220,15 @@ namespace vkma_xml {
                                    type::alias, type::base>;
       state_t state;
       type_tag tag;
+      size_t index = 0; // Dense, assigned by 'type_registry' in the order of the first mention.
     };
 
     struct enum_t {
       identifier_t name;
       type::enumeration state;
+
+      // Every enumerator seen so far (aliases included) with its folded value.
+      transparent_map<std::optional<std::int64_t>> index;
     };
     struct function_t {
       identifier_t name;
@@ -114,24 +237,28 @@ namespace vkma_xml {
 
     class type_registry {
     protected:
-      struct underlying_comparator_t : std::equal_to<> {
-        using is_transparent = void;
-      };
-      struct underlying_hash_t {
-        using is_transparent = underlying_comparator_t::is_transparent;
-        using transparent_key_equal = underlying_comparator_t;
-        size_t operator()(std::string_view txt) const { return std::hash<std::string_view>{}(txt); }
-        size_t operator()(std::string const &txt) const {
-          return std::hash<std::string_view>{}(txt);
-        }
-        size_t operator()(char const *txt) const { return std::hash<std::string_view>{}(txt); }
-      };
-      using underlying_t
-        = std::unordered_map<identifier_t, type_t, underlying_hash_t, underlying_comparator_t>;
+      using underlying_t = transparent_map<type_t>;
 
     public:
+      using value_type = typename underlying_t::value_type;
+
+      type_registry() = default;
+      type_registry(type_registry &&) = default;
+      type_registry &operator=(type_registry &&) = default;
+      type_registry(type_registry const &other) : underlying(other.underlying) { reindex(); }
+      type_registry &operator=(type_registry const &other) {
+        underlying = other.underlying;
+        reindex();
+        return *this;
+      }
+
       typename underlying_t::iterator get(identifier_t &&name);
-      inline auto get(std::string_view name) { return get(identifier_t(name)); }
+      // Only allocates a key for a name seen for the first time.
+      inline auto get(std::string_view name) {
+        if (auto iterator = underlying.find(name); iterator != underlying.end())
+          return iterator;
+        return get(identifier_t(name));
+      }
       typename underlying_t::iterator add(identifier_t &&name, type_t &&type_data);
       inline auto add(std::string_view name, type_t &&type_data) {
         return add(identifier_t(name), std::move(type_data));
@@ -145,33 +272,226 @@ namespace vkma_xml {
       inline auto empty() const { return underlying.empty(); }
       inline auto size() const { return underlying.size(); }
 
+      // Entries in the order of their indices. Unlike 'begin()'/'end()', it is deterministic.
+      inline auto const &entries() const { return ordered; }
+
+    protected:
+      void reindex();
+
     protected:
       underlying_t underlying;
+      std::vector<value_type *> ordered;
+    };
+
+    struct api_t;
+
+    // The 'add'/'get' calls one thread made, in order. 'replay' makes them on a 'type_registry'
+    // (or through an 'api_t') with the same result (indices and warnings included) as making
+    // them there directly.
+    class registry_journal_t {
+    public:
+      using record_t = std::pair<identifier_t, std::optional<type_t>>; // 'get' without type.
+
+      inline void add(identifier_t &&name, type_t &&type_data) {
+        records.emplace_back(std::move(name), std::move(type_data));
+      }
+      inline void get(identifier_t &&name) { records.emplace_back(std::move(name), std::nullopt); }
+      void replay(type_registry &output);
+      void replay(api_t &output);
+      inline auto const &calls() const { return records; }
+
+    protected:
+      std::vector<record_t> records;
+    };
+
+    // Accepts 'add'/'get' from many threads at once. Nothing is resolved until 'merge', which
+    // replays every call into an 'api_t' in the order of their sequence numbers: the result
+    // (indices and warnings included) is the same as the one of serial insertion.
+    // Sequence numbers are '{ source, position within the source }' and must be unique.
+    class sharded_registry_t {
+    public:
+      using sequence_t = std::pair<size_t, size_t>;
+
+      sharded_registry_t(size_t shard_count = 16) : shards(shard_count) {}
+
+      void add(sequence_t sequence, identifier_t &&name, type_t &&type_data);
+      void get(sequence_t sequence, identifier_t &&name);
+      void merge(api_t &output);
+
+    protected:
+      struct record_t {
+        sequence_t sequence;
+        identifier_t name;
+        std::optional<type_t> type_data; // 'std::nullopt' for 'get'.
+      };
+      struct shard_t {
+        std::mutex mutex;
+        std::vector<record_t> records;
+      };
+      void insert(record_t &&record);
+
+    protected:
+      std::vector<shard_t> shards;
+    };
+
+    // Members of a tar archive (ustar, pax and GNU long names), gzip-compressed or not, streamed
+    // one at a time: neither the archive nor its decompressed contents are ever held whole.
+    class archive_t {
+    public:
+      struct member_t {
+        std::string name;
+        std::string content;
+      };
+
+      archive_t(archive_t &&) noexcept;
+      archive_t &operator=(archive_t &&) noexcept;
+      ~archive_t();
+
+      static std::optional<archive_t> open(std::filesystem::path const &file);
+      // The next regular file, 'std::nullopt' past the last one or if the rest is unreadable.
+      std::optional<member_t> next();
+      inline auto const &path() const { return file; }
+
+    protected:
+      archive_t();
+      // Exactly 'size' decompressed bytes, 'false' if the archive ends before.
+      bool read(char *output, size_t size);
+      bool skip(size_t size);
+
+    protected:
+      struct state_t;
+      std::filesystem::path file;
+      std::unique_ptr<state_t> state;
+    };
+
+    // Part 'index' out of 'count' of the compounds listed in the doxygen index of every input (of
+    // its header files with the header frontend), in their order. Handles go with the last part.
+    struct shard_t {
+      size_t index;
+      size_t count;
+
+      inline bool is_last() const { return index + 1 == count; }
+      template <typename T>
+      void select(std::vector<T> &items) const {
+        auto size = items.size();
+        items.erase(items.begin() + size * (index + 1) / count, items.end());
+        items.erase(items.begin(), items.begin() + size * index / count);
+      }
     };
 
     struct api_t {
+      // File compounds with at least twice as many members are split into chunks of at least
+      // this size, parsed concurrently.
+      static constexpr size_t file_chunk_size = 256;
+
+      // The text of a compound. Helper entities keep the part of it they are decoded from, not
+      // the document, until something looks inside them.
+      using source_t = std::shared_ptr<std::string const>;
+
+      static variable_t make_variable(identifier_t &&name, std::string &&type,
+                                      std::string &&argsstring);
       static std::optional<variable_t> load_variable(pugi::xml_node const &xml);
       static std::optional<constant_t> load_define(pugi::xml_node const &xml);
       static std::optional<enum_t> load_enum(pugi::xml_node const &xml);
       static std::optional<variable_t> load_typedef(pugi::xml_node const &xml);
       static std::optional<variable_t> load_function_parameter(pugi::xml_node const &xml);
-      static std::optional<function_t> load_function(pugi::xml_node const &xml);
+      static std::vector<variable_t> load_function_parameters(pugi::xml_node const &xml);
+      // With an 'owner', the parameters are left undecoded.
+      static std::optional<function_t> load_function(pugi::xml_node const &xml,
+                                                     source_t const &owner = nullptr);
       static std::optional<type::function_pointer>
       load_function_pointer(std::string_view type_name);
+      static void append_enumerator(enum_t &output, identifier_t &&name, value_t &&value);
+      static std::optional<type_t> make_typedef(variable_t const &type_def, type_tag tag);
+      // 64-bit flag bits are 'static const' values of a 'VkFlags64' typedef rather than an enum
+      // (the typedef of 'type', one of 'typedefs'). 'output' collects them by typedef name, then
+      // 'apply_flag_bits' turns that typedef into an enumeration of them. 'false' if the value
+      // is not a flag bit.
+      static bool append_flag_bit(transparent_map<enum_t> &output,
+                                  transparent_set const &typedefs, std::string_view type,
+                                  identifier_t &&name, value_t &&value);
+      static void apply_flag_bits(transparent_map<enum_t> const &flag_bits,
+                                  identifier_t const &name, type_t &type_data);
+
+      // 'std::nullopt' for the members that are ignored.
+      static std::optional<std::pair<identifier_t, type_t>>
+      load_file_member(pugi::xml_node const &member, type_tag tag,
+                       source_t const &owner = nullptr);
 
-      void load_struct(pugi::xml_node const &xml, type_tag tag);
-      void load_file(pugi::xml_node const &xml, type_tag tag);
+      static std::vector<variable_t> load_struct_members(pugi::xml_node const &xml);
+      // With an 'owner', the members are left undecoded.
+      void load_struct(pugi::xml_node const &xml, type_tag tag, source_t const &owner = nullptr);
+      void load_file(pugi::xml_node const &xml, type_tag tag, source_t const &owner = nullptr);
+      // 'false' if 'source' is not a valid document.
+      bool load_compound(source_t const &source, std::filesystem::path const &file, type_tag tag);
       void load_compound(std::string_view refid, std::filesystem::path const &directory,
                          type_tag tag);
-      void load_helper(input const &helper_api);
+      static std::vector<std::string_view> load_index_refids(pugi::xml_node const &index);
+      void load_index(pugi::xml_node const &index, std::filesystem::path const &directory,
+                      type_tag tag);
+      // One pass over the archive: the compounds are parsed in the archive order and added to the
+      // registry in the order of the outermost 'index.xml'.
+      bool load_index(archive_t &archive, type_tag tag);
+      // 'xml_directory' is either a directory or a (gzip-compressed) tar archive of one.
+      bool load_doxygen(std::filesystem::path const &xml_directory, type_tag tag);
+      // The doxygen output and the handles of an input. 'false' if there is no doxygen output.
+      bool load_input(input const &api, type_tag tag);
+
+      static void load_header(std::string_view source, type_tag tag, sharded_registry_t &output,
+                              size_t source_index);
+      void load_header(std::string_view source, type_tag tag);
+      void load_headers(std::vector<std::filesystem::path> const &files, type_tag tag);
+
+      // Every loaded entry goes through these.
+      void add(identifier_t &&name, type_t &&type_data);
+      void get(identifier_t &&name);
 
     public:
+      std::shared_ptr<typename_table_t> typenames = share_typenames();
       type_registry registry;
+      // When engaged, loaded entries are recorded into it instead of being added to 'registry',
+      // so that inputs can be loaded concurrently and still reach one registry in their order.
+      std::optional<registry_journal_t> journal;
+      // When engaged, only that part of every input is loaded. The result keeps the journal of
+      // every input, in the input order, and leaves 'registry' empty: shards are merged one
+      // input at a time. See "shard.hpp".
+      std::optional<shard_t> shard;
+      std::vector<registry_journal_t> partial_journals;
+      // Of what every shard of the same set reads whole: the frontend, the doxygen index (or the
+      // archive) and the header files of every input, with its tag, in the input order.
+      std::uint64_t input_fingerprint = 0;
     };
 
-    struct generator_t {
-      static void append_typename(pugi::xml_node &xml, decorated_typename_t const &type);
+    // Set of registry entries (by their index) that remembers the order of insertion.
+    class appended_set_t {
+    public:
+      inline bool contains(size_t index) const { return index < flags.size() && flags[index]; }
+      inline bool emplace(size_t index, std::string_view name) {
+        if (contains(index))
+          return false;
+        if (index >= flags.size())
+          flags.resize(index + 1);
+        flags[index] = true;
+        order.emplace_back(name);
+        return true;
+      }
+      inline void reserve(size_t size) {
+        flags.resize(std::max(flags.size(), size));
+        order.reserve(size);
+      }
+
+      inline auto begin() const { return order.begin(); }
+      inline auto end() const { return order.end(); }
+      inline auto empty() const { return order.empty(); }
+      inline auto size() const { return order.size(); }
 
+    protected:
+      std::vector<bool> flags;
+      std::vector<std::string_view> order;
+    };
+
+    class emitter_t;
+    struct generator_t {
       void append_header();
       void append_types();
       void append_enumerations();
@@ -179,22 +499,120 @@ namespace vkma_xml {
       void append_feature();
       void append_footer();
 
+      // Restricts the output to the transitive closure of the entries matching any of 'roots'.
+      // Patterns may contain '*' and '?' wildcards.
+      void select(std::vector<std::string_view> const &roots);
+      inline bool is_selected(size_t index) const {
+        return selected.empty() || (index < selected.size() && selected[index]);
+      }
+
+      // Success and error codes of 'VkResult' in the 'vk.xml' attribute format. Computed from
+      // 'api' the first time a command needs them, then reused for the rest of the pass.
+      std::pair<std::string, std::string> const &result_codes();
+
+      // Forwards an element to every emitter.
+      template <typename... argument_ts, typename... value_ts>
+      void emit(void (emitter_t::*method)(argument_ts...), value_ts &&...values);
+
     public:
-      generator_t(api_t const &api);
+      generator_t(api_t const &api, std::vector<emitter_t *> const &emitters);
 
     public:
       api_t const &api;
-      std::unordered_set<std::string_view> appended_basetypes;
-      std::unordered_set<std::string_view> appended_types;
-      std::unordered_set<std::string_view> appended_commands;
-      std::unordered_set<std::string_view> appended_constants;
-      std::optional<pugi::xml_document> output;
-      std::optional<pugi::xml_node> registry;
+      appended_set_t appended_basetypes;
+      appended_set_t appended_types;
+      appended_set_t appended_commands;
+      appended_set_t appended_constants;
+      std::vector<emitter_t *> emitters;
+      std::vector<bool> selected; // Empty unless 'select' was called.
+      std::optional<std::pair<std::string, std::string>> result_code_lists;
+    };
+
+    // Reads files on the executor of the current call (see "async.hpp"), at most 'window' files
+    // ahead of the consumer. 'next' hands the contents over in the order of 'files', reading a
+    // file itself if no worker has claimed it yet: the workers are only an offer to help.
+    // 'std::nullopt' means the file could not be read. The workers work for the call that
+    // constructs it, and stop reading ahead once that call is stopped.
+    class read_ahead_t {
+    public:
+      read_ahead_t(std::vector<std::filesystem::path> const &files, size_t thread_count = 4,
+                   size_t window = 64);
+      ~read_ahead_t();
+      read_ahead_t(read_ahead_t const &) = delete;
+      read_ahead_t &operator=(read_ahead_t const &) = delete;
+
+      std::optional<std::string> next();
+      size_t size() const;
+
+    protected:
+      // Shared with the workers, which may be started after it is destroyed.
+      struct state_t;
+      std::shared_ptr<state_t> state;
     };
 
     std::optional<pugi::xml_document> load_xml(std::filesystem::path const &file);
+    std::optional<pugi::xml_document> load_xml(std::string_view source,
+                                               std::filesystem::path const &file);
     std::map<identifier_t, type::handle>
     load_handle_list(std::vector<std::filesystem::path> const &files);
+    std::optional<std::string> load_text(std::filesystem::path const &file);
+    std::optional<std::int64_t>
+    evaluate_expression(std::string_view expression,
+                        std::function<std::optional<std::int64_t>(std::string_view)> const &lookup);
+
+    // Bitmask names end with "Flags" or "FlagBits", then maybe a revision number and a vendor
+    // suffix: 'VkAccessFlags2KHR'. The flag bits name of a bitmask if 'name' is one.
+    std::optional<identifier_t> flag_bits_of(std::string_view name);
+    bool is_flag_bits(std::string_view name);
+
+    // A perfect hash over a fixed set of strings, searched for at compile time: 'find' is one
+    // hash, one table load and one comparison. It returns the position of 'token' in the set as
+    // 'result_t' (an enum listing the strings in order, followed by 'unknown'), or the size of
+    // the set if 'token' is not there.
+    template <size_t token_count, typename result_t = size_t>
+    class token_table_t {
+    public:
+      consteval token_table_t(std::array<std::string_view, token_count> const &tokens)
+        : tokens(tokens) {
+        for (;; ++seed) {
+          slots.fill(empty);
+          bool is_perfect = true;
+          for (size_t i = 0; i < token_count && is_perfect; ++i)
+            if (auto &slot = slots[hash(tokens[i], seed) % slot_count]; slot == empty)
+              slot = std::uint8_t(i);
+            else
+              is_perfect = false;
+          if (is_perfect)
+            return;
+        }
+      }
+
+      constexpr result_t find(std::string_view token) const {
+        auto index = slots[hash(token, seed) % slot_count];
+        return result_t(index != empty && tokens[index] == token ? index : token_count);
+      }
+      constexpr bool contains(std::string_view token) const {
+        return find(token) != result_t(token_count);
+      }
+
+    protected:
+      static_assert(token_count < 0xff);
+      static constexpr size_t slot_count = std::bit_ceil(token_count * 2);
+      static constexpr std::uint8_t empty = 0xff;
+
+      // 32-bit FNV-1a, offset by the seed.
+      static constexpr std::uint32_t hash(std::string_view token, std::uint32_t seed) {
+        std::uint32_t value = 2166136261u ^ seed;
+        for (auto character : token)
+          value = (value ^ static_cast<unsigned char>(character)) * 16777619u;
+        return value;
+      }
+
+    protected:
+      std::array<std::string_view, token_count> tokens;
+      std::array<std::uint8_t, slot_count> slots{};
+      std::uint32_t seed = 0;
+    };
 
     using namespace std::string_view_literals;
     constexpr std::array base_types = { "void"sv,
@@ -229,6 +647,30 @@ namespace vkma_xml {
     constexpr std::array accepted_prefixes{ "*"sv,    "&"sv,      " "sv,    "const"sv,
                                             "enum"sv, "struct"sv, "union"sv };
     constexpr std::array accepted_postfixes{ "*"sv, "&"sv, " "sv, "const"sv };
+
+    // Mirrors 'PREDEFINED' entries of the doxyfiles: the header frontend erases these the same
+    // way doxygen preprocessor does. Calling convention macros are erased as well.
+    constexpr token_table_t ignored_macros{ std::array{ "VMA_CALL_PRE"sv,
+                                                      "VMA_CALL_POST"sv,
+                                                      "VKAPI_PTR"sv,
+                                                      "VKAPI_ATTR"sv,
+                                                      "VKAPI_CALL"sv,
+                                                      "VMA_NULLABLE"sv,
+                                                      "VMA_NULLABLE_NON_DISPATCHABLE"sv,
+                                                      "VMA_NOT_NULL"sv,
+                                                      "VMA_NOT_NULL_NON_DISPATCHABLE"sv,
+                                                      "VMA_LEN_IF_NOT_NULL"sv,
+                                                      "VMA_EXTENDS_VK_STRUCT"sv } };
+
+    // The first input is the main one. 'std::nullopt' if it could not be loaded or the call
+    // was stopped, see "async.hpp". A 'shard' is left unfinished: without the base types, its
+    // undefined types are expected to be defined by the other shards.
+    std::optional<api_t> parse(std::vector<input const *> const &inputs,
+                               std::optional<shard_t> shard = std::nullopt);
+    std::optional<api_t> parse_headers(std::vector<input const *> const &inputs,
+                                       std::optional<shard_t> shard = std::nullopt);
+    // Adds the base types and reports the types left undefined.
+    void finish_parsing(api_t &api, std::chrono::high_resolution_clock::time_point start_time);
   } // namespace detail
 
   std::optional<detail::api_t> parse(input main_api,
@@ -238,7 +680,17 @@ namespace vkma_xml {
     return parse(main_api, std::initializer_list<input>{ helper_apis... });
   }
 
+  std::optional<detail::api_t> parse_headers(input main_api,
+                                             std::initializer_list<input> const &helper_apis);
+  template <detail::parser_input... helper_api_ts>
+  std::optional<detail::api_t> parse_headers(input main_api, helper_api_ts... helper_apis) {
+    return parse_headers(main_api, std::initializer_list<input>{ helper_apis... });
+  }
+
+  // 'std::nullopt' if the current call was stopped.
   std::optional<pugi::xml_document> generate(detail::api_t const &api);
+  std::optional<pugi::xml_document> generate(detail::api_t const &api,
+                                             std::vector<std::string_view> const &roots);
   template <detail::parser_input... helper_api_ts>
   std::optional<pugi::xml_document> generate(input main_api, helper_api_ts... helper_apis) {
     if (auto api = parse(main_api, helper_apis...); api)
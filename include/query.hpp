@@ -0,0 +1,70 @@
+// Copyright (c) 2021 Cvelth <cvelth.mail@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <array>
+#include <string_view>
+#include <vector>
+
+#include "generator.hpp"
+
+namespace vkma_xml {
+  // Mirrors the alternatives of 'detail::type_t::state_t'.
+  enum class type_kind : size_t {
+    undefined,
+    structure,
+    handle,
+    macro,
+    enumeration,
+    function,
+    function_pointer,
+    alias,
+    base
+  };
+  inline type_kind kind_of(detail::type_t const &type) {
+    return static_cast<type_kind>(type.state.index());
+  }
+
+  // Read-only view of a parsed api with precomputed dependency indexes.
+  // Lookups and list queries are O(1), closures are O(result).
+  // The api must outlive the query: returned entries point into its registry.
+  // The members of helper structs and the parameters of helper functions are not looked into,
+  // the generator only ever declares those, so building a query decodes nothing.
+  class query_t {
+  public:
+    using entry_t = detail::type_registry::value_type;
+    using entry_list_t = std::vector<entry_t const *>;
+
+    explicit query_t(detail::api_t const &api);
+
+    entry_t const *find(std::string_view name) const;
+    // Every entry, in the registry order.
+    inline auto const &entries() const { return api.registry.entries(); }
+    // Every entry of a kind, in the registry order.
+    entry_list_t const &of_kind(type_kind kind, detail::type_tag tag) const;
+    // Entries the definition of 'name' refers to directly, each once.
+    entry_list_t const &dependencies(std::string_view name) const;
+    inline entry_list_t const &dependencies(entry_t const &entry) const {
+      return dependency_lists[entry.second.index];
+    }
+    // Entries (types and commands) that refer to 'name' directly.
+    entry_list_t const &users(std::string_view name) const;
+    inline entry_list_t const &users(entry_t const &entry) const {
+      return user_lists[entry.second.index];
+    }
+    // 'roots' and everything they depend on transitively, dependencies first.
+    entry_list_t closure(entry_list_t const &roots) const;
+    entry_list_t closure(std::string_view name) const;
+
+  protected:
+    static constexpr size_t kind_count = std::variant_size_v<detail::type_t::state_t>;
+    static constexpr size_t tag_count = 2;
+
+    detail::api_t const &api;
+    std::array<entry_list_t, kind_count * tag_count> kinds;
+    std::vector<entry_list_t> dependency_lists;
+    std::vector<entry_list_t> user_lists;
+    inline static entry_list_t const empty_list = {};
+  };
+} // namespace vkma_xml
@@ -0,0 +1,33 @@
+// Copyright (c) 2021 Cvelth <cvelth.mail@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+#include "generator.hpp"
+
+namespace vkma_xml {
+  // Parsing spread across processes: each one parses a 'detail::shard_t' of the inputs and saves
+  // its partial registry as the 'add'/'get' calls that build it, so that what it only refers to
+  // stays a placeholder and what it defines goes through the conflict rules of
+  // 'type_registry::add' against every other shard. 'merge_shards' replays them input by input,
+  // shard by shard, into the registry a single 'parse' of the whole inputs makes (indices and
+  // warnings included), and finishes it.
+  // A shard file records its part and the 'input_fingerprint' of what it was parsed from, so
+  // 'paths' may come in any order: 'std::nullopt' unless they are every part of one set, once.
+  bool save_shard(detail::api_t const &api, std::filesystem::path const &path);
+  std::optional<detail::api_t> merge_shards(std::vector<std::filesystem::path> const &paths);
+
+  namespace detail {
+    struct shard_file_t {
+      shard_t shard;
+      std::uint64_t input_fingerprint;
+      std::vector<registry_journal_t> journals; // One per input, in the input order.
+    };
+    std::optional<shard_file_t> load_shard(std::filesystem::path const &path);
+  } // namespace detail
+} // namespace vkma_xml
@@ -0,0 +1,45 @@
+// Copyright (c) 2021 Cvelth <cvelth.mail@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace vkma_xml {
+  namespace detail {
+    // Named tasks together with the tasks each of them waits for, run on a pool of threads.
+    // A worker keeps the tasks it made ready on its own deque and runs the newest one first, so
+    // a task usually follows its dependency on the same thread. A worker that runs out steals
+    // the oldest task of another one.
+    class task_graph_t {
+    public:
+      using task_id = size_t;
+
+      // Dependencies have to be added first, so the graph can never contain a cycle.
+      task_id add(std::string_view name, std::function<void()> &&task,
+                  std::vector<task_id> const &dependencies = {});
+      inline size_t size() const { return nodes.size(); }
+
+      // Blocks until every task is done, the calling thread being one of the workers. Once a
+      // task throws, the tasks that have not started yet are skipped and the first exception
+      // is rethrown. The same goes for a stop requested of the current call, see "async.hpp",
+      // except that it returns 'false' instead. The other workers run on its executor.
+      bool run(size_t thread_count = std::thread::hardware_concurrency());
+
+    protected:
+      struct node_t {
+        std::string name;
+        std::function<void()> task;
+        std::vector<task_id> dependents;
+        size_t dependency_count;
+      };
+
+    protected:
+      std::vector<node_t> nodes;
+    };
+  } // namespace detail
+} // namespace vkma_xml
@@ -0,0 +1,42 @@
+// Copyright (c) 2021 Cvelth <cvelth.mail@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+namespace vkma_xml {
+  // Records spans from every thread once enabled. 'save_trace' writes them as Chrome
+  // trace-event json (opens in Perfetto or 'chrome://tracing').
+  void enable_trace();
+  bool save_trace(std::filesystem::path const &path);
+
+  namespace detail {
+    inline std::atomic<bool> trace_enabled = false;
+
+    // A complete ('X') event spanning the lifetime of the object. Does nothing unless tracing is
+    // enabled: check it before computing expensive arguments.
+    class trace_span_t {
+    public:
+      explicit trace_span_t(std::string_view name);
+      ~trace_span_t();
+      trace_span_t(trace_span_t const &) = delete;
+      trace_span_t &operator=(trace_span_t const &) = delete;
+
+      explicit operator bool() const { return active; }
+      trace_span_t &arg(std::string_view key, std::string_view value);
+      trace_span_t &arg(std::string_view key, std::uint64_t value);
+
+    protected:
+      bool active;
+      std::string_view name;
+      std::string args; // Members of the 'args' json object, comma separated.
+      std::chrono::steady_clock::time_point start;
+    };
+  } // namespace detail
+} // namespace vkma_xml
@@ -30,5 +30,24 @@ templated.project "generator"
     templated.files ""
     targetdir "bin/%{cfg.system}_%{cfg.buildcfg}"
 	links "doxygen"
-	depends { "pugixml", "ctre" }
-	
\ No newline at end of file
+	depends { "pugixml", "ctre", "zlib" }
+	
+templated.project "benchmark"
+    templated.kind "ConsoleApp"
+    templated.files "benchmark"
+    files { "include/**.hpp", "source/**.cpp" }
+    includedirs "include"
+    defines "VMA_XML_NO_MAIN"
+    targetdir "bin/%{cfg.system}_%{cfg.buildcfg}"
+	depends { "pugixml", "ctre", "zlib" }
+
+-- Every file in "test/source" is a test of its own: it exits with a non-zero code on failure.
+for _, file in ipairs(os.matchfiles("test/source/*.cpp")) do
+	templated.project("test_" .. path.getbasename(file))
+		templated.kind "ConsoleApp"
+		files { file, "include/**.hpp", "source/**.cpp" }
+		includedirs "include"
+		defines { "VMA_XML_NO_MAIN", "VMA_XML_TEST_FIXTURE=\"" .. _MAIN_SCRIPT_DIR .. "/test/fixture\"" }
+		targetdir "bin/%{cfg.system}_%{cfg.buildcfg}"
+		depends { "pugixml", "ctre", "zlib" }
+end
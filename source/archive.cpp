@@ -0,0 +1,177 @@
+﻿// Copyright (c) 2021 Cvelth <cvelth.mail@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "async.hpp"
+#include "generator.hpp"
+#include "zlib.h"
+using namespace std::string_view_literals;
+
+static size_t parse_number(std::string_view field, size_t base) {
+  size_t output = 0;
+  for (char character : field)
+    if (character >= '0' && static_cast<size_t>(character - '0') < base)
+      output = output * base + (character - '0');
+    else if (character != ' ' || output)
+      break;
+  return output;
+}
+struct vkma_xml::detail::archive_t::state_t {
+  static constexpr size_t buffer_size = 1 << 16;
+
+  std::ifstream stream;
+  std::optional<z_stream> inflater; // Engaged for gzip-compressed archives.
+  std::vector<unsigned char> buffer;
+  bool is_finished = false;
+
+  ~state_t() {
+    if (inflater)
+      inflateEnd(&*inflater);
+  }
+};
+vkma_xml::detail::archive_t::archive_t() : state(std::make_unique<state_t>()) {}
+vkma_xml::detail::archive_t::archive_t(archive_t &&) noexcept = default;
+vkma_xml::detail::archive_t &
+vkma_xml::detail::archive_t::operator=(archive_t &&) noexcept = default;
+vkma_xml::detail::archive_t::~archive_t() = default;
+
+std::optional<vkma_xml::detail::archive_t>
+vkma_xml::detail::archive_t::open(std::filesystem::path const &file) {
+  archive_t output;
+  output.file = file;
+  auto &state = *output.state;
+  state.stream.open(file, std::fstream::binary);
+  std::array<char, 5> magic = {};
+  if (!state.stream.read(magic.data(), magic.size()) && !state.stream.eof()) {
+    detail::message() << "Error: Ignore '" << std::filesystem::absolute(file)
+                      << "'. Unable to read it. Make sure it exists and is accessible.\n";
+    return std::nullopt;
+  }
+  std::string_view header(magic.data(), state.stream.gcount());
+  for (auto unsupported : { "\x28\xb5\x2f\xfd"sv, "\xfd\x37\x7a\x58\x5a"sv, "BZh"sv })
+    if (header.substr(0, unsupported.size()) == unsupported) {
+      detail::message() << "Error: Ignore '" << std::filesystem::absolute(file)
+                        << "'. Only gzip-compressed archives are supported, recompress it.\n";
+      return std::nullopt;
+    }
+  if (header.substr(0, 2) == "\x1f\x8b"sv) {
+    state.inflater.emplace();
+    if (inflateInit2(&*state.inflater, 16 + MAX_WBITS) != Z_OK) {
+      state.inflater.reset();
+      detail::message() << "Error: Ignore '" << std::filesystem::absolute(file)
+                        << "'. Unable to start decompressing it.\n";
+      return std::nullopt;
+    }
+    state.buffer.resize(state_t::buffer_size);
+  }
+  state.stream.clear();
+  state.stream.seekg(0);
+  return output;
+}
+bool vkma_xml::detail::archive_t::read(char *output, size_t size) {
+  if (!state->inflater)
+    return state->stream.read(output, size) || static_cast<size_t>(state->stream.gcount()) == size;
+
+  auto &inflater = *state->inflater;
+  inflater.next_out = reinterpret_cast<unsigned char *>(output);
+  inflater.avail_out = static_cast<unsigned>(size);
+  while (inflater.avail_out) {
+    if (!inflater.avail_in) {
+      state->stream.read(reinterpret_cast<char *>(state->buffer.data()), state->buffer.size());
+      if (!state->stream.gcount())
+        return false;
+      inflater.next_in = state->buffer.data();
+      inflater.avail_in = static_cast<unsigned>(state->stream.gcount());
+    }
+    if (auto result = inflate(&inflater, Z_NO_FLUSH); result == Z_STREAM_END)
+      inflateReset(&inflater); // 'gzip' output may consist of several concatenated members.
+    else if (result != Z_OK) {
+      detail::message() << "Error: " << std::filesystem::absolute(file)
+                        << " is corrupted: " << (inflater.msg ? inflater.msg : "unknown error")
+                        << ".\n";
+      return false;
+    }
+  }
+  return true;
+}
+bool vkma_xml::detail::archive_t::skip(size_t size) {
+  if (!state->inflater)
+    return static_cast<bool>(state->stream.seekg(size, std::fstream::cur));
+  std::array<char, 4096> discarded;
+  for (size_t step; size; size -= step)
+    if (step = std::min(size, discarded.size()); !read(discarded.data(), step))
+      return false;
+  return true;
+}
+std::optional<vkma_xml::detail::archive_t::member_t> vkma_xml::detail::archive_t::next() {
+  constexpr size_t block_size = 512;
+  std::array<char, block_size> block;
+  std::string long_name;
+  while (!state->is_finished) {
+    if (!read(block.data(), block.size()) || block.front() == '\0') {
+      state->is_finished = true; // The end-of-archive marker (or the end of the file).
+      break;
+    }
+    std::string_view header(block.data(), block.size());
+    auto field = [&header](size_t begin, size_t length) {
+      auto value = header.substr(begin, length);
+      return value.substr(0, value.find('\0'));
+    };
+
+    size_t const size = parse_number(field(124, 12), 8);
+    size_t const padding = (block_size - size % block_size) % block_size;
+    std::string name;
+    if (!long_name.empty())
+      name = std::move(long_name);
+    else if (auto prefix = field(345, 155); field(257, 5) == "ustar"sv && !prefix.empty())
+      name = std::string(prefix) + '/' + std::string(field(0, 100));
+    else
+      name = field(0, 100);
+    long_name.clear();
+
+    char const type = header[156];
+    bool const is_file = type == '0' || type == '\0' || type == '7';
+    std::string content;
+    if (is_file || type == 'L' || type == 'x') {
+      content.resize(size);
+      if (!read(content.data(), size) || !skip(padding)) {
+        detail::message() << "Warning: " << std::filesystem::absolute(file) << " is truncated.\n";
+        state->is_finished = true;
+        break;
+      }
+    } else if (!skip(size + padding)) {
+      detail::message() << "Warning: " << std::filesystem::absolute(file) << " is truncated.\n";
+      state->is_finished = true;
+      break;
+    }
+
+    if (type == 'L')
+      // GNU long name of the next member.
+      long_name = content.substr(0, content.find('\0'));
+    else if (type == 'x')
+      // Pax extended header: a list of "<length> <key>=<value>\n" records.
+      for (std::string_view records = content; !records.empty();) {
+        auto space = records.find(' ');
+        auto length = parse_number(records.substr(0, space), 10);
+        if (space == std::string_view::npos || !length || length > records.size())
+          break;
+        if (auto record = records.substr(space + 1, length - space - 2);
+            record.substr(0, 5) == "path="sv)
+          long_name = record.substr(5);
+        records.remove_prefix(length);
+      }
+    else if (is_file) {
+      while (name.substr(0, 2) == "./")
+        name.erase(0, 2);
+      return member_t{ std::move(name), std::move(content) };
+    }
+  }
+  return std::nullopt;
+}
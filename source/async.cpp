@@ -0,0 +1,233 @@
+﻿// Copyright (c) 2021 Cvelth <cvelth.mail@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "async.hpp"
+
+namespace {
+  // The executor of the calls that bring none: a thread per core, made on first use and shared
+  // by every call and every task graph and reader within them. The threads are joined once the
+  // program exits, the jobs they never got to are destroyed then.
+  class default_pool_t {
+  public:
+    default_pool_t() {
+      auto thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+      threads.reserve(thread_count);
+      for (unsigned i = 0; i < thread_count; ++i)
+        threads.emplace_back([this] { work(); });
+    }
+    ~default_pool_t() {
+      {
+        std::lock_guard lock(mutex);
+        is_stopping = true;
+      }
+      wake.notify_all();
+      for (auto &thread : threads)
+        thread.join();
+    }
+
+    void run(std::function<void()> &&job) {
+      {
+        std::lock_guard lock(mutex);
+        jobs.emplace_back(std::move(job));
+      }
+      wake.notify_one();
+    }
+
+  protected:
+    void work() {
+      while (true) {
+        std::function<void()> job;
+        {
+          std::unique_lock lock(mutex);
+          wake.wait(lock, [this] { return is_stopping || !jobs.empty(); });
+          if (is_stopping)
+            return;
+          job = std::move(jobs.front());
+          jobs.pop_front();
+        }
+        job();
+      }
+    }
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<std::function<void()>> jobs;
+    bool is_stopping = false;
+    std::vector<std::thread> threads;
+  };
+
+  void dispatch(vkma_xml::executor_t const &executor, std::function<void()> &&job) {
+    if (executor)
+      executor(std::move(job));
+    else {
+      static default_pool_t default_pool;
+      default_pool.run(std::move(job));
+    }
+  }
+
+  // Runs 'job' on the executor of 'options' as a call of its own. 'stopped' is the result of a
+  // call that is stopped before it gets to start.
+  template <typename result_t, typename job_t>
+  std::future<result_t> start(vkma_xml::run_options_t &&options, result_t stopped, job_t &&job) {
+    // Shared with what is decoded lazily, which may report to the call after it returns. The
+    // result is not, it may hold those decoders.
+    struct state_t {
+      vkma_xml::run_options_t options;
+      std::mutex callback_mutex;
+    };
+    auto state = std::make_shared<state_t>();
+    state->options = std::move(options);
+    auto promise = std::make_shared<std::promise<result_t>>();
+    auto output = promise->get_future();
+    dispatch(state->options.executor, [state, promise, stopped = std::move(stopped),
+                                       job = std::forward<job_t>(job)]() mutable {
+      vkma_xml::detail::run_context_t context{ state->options, state->callback_mutex, true,
+                                               state };
+      vkma_xml::detail::run_scope_t scope(&context);
+      try {
+        if (vkma_xml::detail::is_stop_requested())
+          promise->set_value(std::move(stopped));
+        else
+          promise->set_value(job());
+      } catch (...) {
+        promise->set_exception(std::current_exception());
+      }
+    });
+    return output;
+  }
+
+  // Owns what an 'input' refers to.
+  struct input_copy_t {
+    std::filesystem::path xml_directory;
+    std::vector<std::filesystem::path> header_files;
+    bool is_core;
+
+    vkma_xml::input get() const { return { xml_directory, header_files, is_core }; }
+  };
+  std::vector<input_copy_t> copy_inputs(vkma_xml::input const &main_api,
+                                        std::vector<vkma_xml::input> const &helper_apis) {
+    std::vector<input_copy_t> output;
+    output.reserve(helper_apis.size() + 1);
+    output.emplace_back(input_copy_t{ main_api.xml_directory, main_api.header_files,
+                                      main_api.is_core });
+    for (auto const &helper_api : helper_apis)
+      output.emplace_back(
+        input_copy_t{ helper_api.xml_directory, helper_api.header_files, helper_api.is_core });
+    return output;
+  }
+
+  template <typename parse_t>
+  std::future<std::optional<vkma_xml::detail::api_t>>
+  start_parsing(std::vector<input_copy_t> &&copies, vkma_xml::run_options_t &&options,
+                parse_t parse) {
+    return start(std::move(options), std::optional<vkma_xml::detail::api_t>{},
+                 [copies = std::move(copies), parse] {
+                   std::vector<vkma_xml::input> inputs;
+                   inputs.reserve(copies.size());
+                   for (auto const &copy : copies)
+                     inputs.emplace_back(copy.get());
+                   std::vector<vkma_xml::input const *> pointers;
+                   for (auto const &input : inputs)
+                     pointers.emplace_back(&input);
+                   return parse(pointers);
+                 });
+  }
+} // namespace
+
+vkma_xml::detail::run_scope_t::run_scope_t(run_context_t const *context)
+  : previous(current_run) {
+  if (context)
+    current_run = context;
+}
+vkma_xml::detail::run_scope_t::~run_scope_t() { current_run = previous; }
+
+void vkma_xml::detail::execute(std::function<void()> &&job) {
+  dispatch(current_run ? current_run->options.executor : executor_t{}, std::move(job));
+}
+bool vkma_xml::detail::is_stop_requested() {
+  return current_run && current_run->options.stop_token.stop_requested();
+}
+void vkma_xml::detail::report_progress(std::string_view step, size_t done, size_t total) {
+  if (current_run && current_run->reports_progress && current_run->options.on_progress) {
+    std::lock_guard lock(current_run->callback_mutex);
+    current_run->options.on_progress(step, done, total);
+  }
+}
+
+namespace {
+  thread_local vkma_xml::detail::message_buffer_t *current_buffer = nullptr;
+
+  void emit(std::string const &text) {
+    using vkma_xml::detail::current_run;
+    if (current_run && current_run->options.on_message) {
+      std::string_view view = text;
+      while (view.ends_with('\n'))
+        view.remove_suffix(1);
+      std::lock_guard lock(current_run->callback_mutex);
+      current_run->options.on_message(view);
+    } else {
+      static std::mutex mutex;
+      std::lock_guard lock(mutex);
+      std::cout << text << std::flush;
+    }
+  }
+} // namespace
+
+vkma_xml::detail::message_t::~message_t() {
+  auto text = std::move(stream).str();
+  if (text.empty())
+    return;
+  if (current_buffer)
+    current_buffer->messages.emplace_back(std::move(text));
+  else
+    emit(text);
+}
+
+vkma_xml::detail::message_buffer_t::capture_t::capture_t(message_buffer_t &buffer)
+  : previous(std::exchange(current_buffer, &buffer)) {}
+vkma_xml::detail::message_buffer_t::capture_t::~capture_t() { current_buffer = previous; }
+void vkma_xml::detail::message_buffer_t::flush() {
+  for (auto &text : messages)
+    if (current_buffer)
+      current_buffer->messages.emplace_back(std::move(text));
+    else
+      emit(text);
+  messages.clear();
+}
+
+std::future<std::optional<vkma_xml::detail::api_t>>
+vkma_xml::parse_async(input main_api, std::vector<input> const &helper_apis,
+                      run_options_t options) {
+  return start_parsing(copy_inputs(main_api, helper_apis), std::move(options),
+                       [](std::vector<input const *> const &inputs) {
+                         return detail::parse(inputs);
+                       });
+}
+std::future<std::optional<vkma_xml::detail::api_t>>
+vkma_xml::parse_headers_async(input main_api, std::vector<input> const &helper_apis,
+                              run_options_t options) {
+  return start_parsing(copy_inputs(main_api, helper_apis), std::move(options),
+                       [](std::vector<input const *> const &inputs) {
+                         return detail::parse_headers(inputs);
+                       });
+}
+
+std::future<bool> vkma_xml::generate_async(detail::api_t const &api,
+                                           std::vector<detail::emitter_t *> emitters,
+                                           std::vector<std::string> roots, run_options_t options) {
+  return start(std::move(options), false,
+               [&api, emitters = std::move(emitters), roots = std::move(roots)] {
+                 return generate(api, emitters,
+                                 std::vector<std::string_view>(roots.begin(), roots.end()));
+               });
+}
@@ -0,0 +1,200 @@
+﻿// Copyright (c) 2021 Cvelth <cvelth.mail@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#include <algorithm>
+
+#include "diff.hpp"
+
+namespace {
+  // 64-bit FNV-1a. Every field is terminated, so that "ab" + "c" differs from "a" + "bc".
+  struct hasher_t {
+    std::uint64_t value = 14695981039346656037ull;
+
+    inline hasher_t &add(std::string_view data) {
+      for (auto character : data)
+        (value ^= static_cast<unsigned char>(character)) *= 1099511628211ull;
+      (value ^= 0xff) *= 1099511628211ull;
+      return *this;
+    }
+    inline hasher_t &add(std::uint64_t number) {
+      for (size_t i = 0; i < sizeof(number); ++i)
+        (value ^= (number >> (i * 8)) & 0xff) *= 1099511628211ull;
+      return *this;
+    }
+  };
+
+  std::uint64_t own_hash(vkma_xml::query_t::entry_t const &entry) {
+    struct own_hash_visitor {
+      hasher_t &hasher_ref;
+
+      inline void add(std::vector<vkma_xml::detail::variable_t> const &variables) {
+        hasher_ref.add(variables.size());
+        for (auto const &variable : variables)
+          hasher_ref.add(variable.name)
+            .add(variable.type.spelling())
+            .add(variable.array ? *variable.array : "");
+      }
+      inline void add(std::vector<vkma_xml::detail::constant_t> const &constants) {
+        hasher_ref.add(constants.size());
+        for (auto const &constant : constants)
+          hasher_ref.add(constant.name).add(constant.value);
+      }
+
+      inline void operator()(vkma_xml::detail::type::undefined const &) {}
+      inline void operator()(vkma_xml::detail::type::structure const &structure) {
+        hasher_ref.add(structure.is_union);
+        add(*structure.members);
+      }
+      inline void operator()(vkma_xml::detail::type::handle const &handle) {
+        hasher_ref.add(handle.dispatchable).add(handle.parent ? *handle.parent : "");
+      }
+      inline void operator()(vkma_xml::detail::type::macro const &macro) {
+        hasher_ref.add(macro.value);
+      }
+      inline void operator()(vkma_xml::detail::type::enumeration const &enumeration) {
+        hasher_ref.add(enumeration.type ? enumeration.type->spelling() : "");
+        add(enumeration.values);
+        add(enumeration.aliases);
+      }
+      inline void operator()(vkma_xml::detail::type::function const &function) {
+        hasher_ref.add(function.return_type.spelling());
+        add(*function.parameters);
+      }
+      inline void operator()(vkma_xml::detail::type::function_pointer const &function_pointer) {
+        hasher_ref.add(function_pointer.return_type.spelling());
+        add(function_pointer.parameters);
+      }
+      inline void operator()(vkma_xml::detail::type::alias const &alias) {
+        hasher_ref.add(alias.real_type.spelling());
+      }
+      inline void operator()(vkma_xml::detail::type::base const &) {}
+    };
+
+    hasher_t hasher;
+    hasher.add(entry.second.state.index()).add(static_cast<std::uint64_t>(entry.second.tag));
+    std::visit(own_hash_visitor{ hasher }, entry.second.state);
+    return hasher.value;
+  }
+} // namespace
+
+vkma_xml::merkle_t::merkle_t(query_t const &query) {
+  auto const &entries = query.entries();
+  owns.resize(entries.size());
+  totals.resize(entries.size());
+  components.resize(entries.size());
+  for (auto const *entry : entries)
+    owns[entry->second.index] = own_hash(*entry);
+
+  // Tarjan's algorithm: components come out dependencies first, so every 'total' a component
+  // refers to outside of itself is already known when it is completed.
+  constexpr size_t unvisited = size_t(-1);
+  std::vector<size_t> order(entries.size(), unvisited);
+  std::vector<size_t> lowlink(entries.size());
+  std::vector<bool> on_stack(entries.size());
+  std::vector<size_t> stack_position(entries.size()); // Valid while the entry is on the stack.
+  std::vector<query_t::entry_t const *> stack;
+  size_t counter = 0;
+  auto visit = [&](auto const &self, query_t::entry_t const *entry) -> void {
+    auto index = entry->second.index;
+    order[index] = lowlink[index] = counter++;
+    stack_position[index] = stack.size();
+    stack.emplace_back(entry);
+    on_stack[index] = true;
+    for (auto const *dependency : query.dependencies(*entry)) {
+      auto dependency_index = dependency->second.index;
+      if (order[dependency_index] == unvisited) {
+        self(self, dependency);
+        lowlink[index] = std::min(lowlink[index], lowlink[dependency_index]);
+      } else if (on_stack[dependency_index])
+        lowlink[index] = std::min(lowlink[index], order[dependency_index]);
+    }
+    if (lowlink[index] != order[index])
+      return;
+
+    auto begin = stack.begin() + stack_position[index];
+    std::vector<query_t::entry_t const *> component(begin, stack.end());
+    stack.erase(begin, stack.end());
+    for (auto const *member : component)
+      on_stack[member->second.index] = false;
+    std::sort(component.begin(), component.end(),
+              [](auto const *left, auto const *right) { return left->first < right->first; });
+
+    hasher_t hasher;
+    for (auto const *member : component)
+      hasher.add(member->first).add(owns[member->second.index]);
+    for (auto const *member : component)
+      for (auto const *dependency : query.dependencies(*member))
+        if (!std::binary_search(component.begin(), component.end(), dependency,
+                                [](auto const *left, auto const *right) {
+                                  return left->first < right->first;
+                                }))
+          hasher.add(dependency->first).add(totals[dependency->second.index]);
+    for (auto const *member : component) {
+      totals[member->second.index] = hasher.value;
+      components[member->second.index] = order[index];
+    }
+  };
+  for (auto const *entry : entries)
+    if (order[entry->second.index] == unvisited)
+      visit(visit, entry);
+}
+
+vkma_xml::diff_t vkma_xml::diff(detail::api_t const &before, detail::api_t const &after) {
+  query_t const before_query(before), after_query(after);
+  return diff(before_query, merkle_t(before_query), after_query, merkle_t(after_query));
+}
+vkma_xml::diff_t vkma_xml::diff(query_t const &before_query, merkle_t const &before_hashes,
+                                query_t const &after_query, merkle_t const &after_hashes) {
+  std::vector<bool> before_visited(before_query.entries().size());
+  std::vector<bool> after_visited(after_query.entries().size());
+
+  diff_t output;
+  auto visit = [&](auto const &self, std::string_view name) -> void {
+    auto const *old_entry = before_query.find(name);
+    auto const *new_entry = after_query.find(name);
+    if ((old_entry && before_visited[old_entry->second.index])
+        || (new_entry && after_visited[new_entry->second.index]))
+      return;
+    if (old_entry)
+      before_visited[old_entry->second.index] = true;
+    if (new_entry)
+      after_visited[new_entry->second.index] = true;
+
+    if (old_entry && new_entry) {
+      if (before_hashes.total(*old_entry) == after_hashes.total(*new_entry))
+        return; // The whole dependency tree is the same.
+      ++output.compared;
+      if (before_hashes.own(*old_entry) != after_hashes.own(*new_entry))
+        output.changed.emplace_back(name);
+    } else if (new_entry)
+      output.added.emplace_back(name);
+    else
+      output.removed.emplace_back(name);
+
+    if (old_entry)
+      for (auto const *dependency : before_query.dependencies(*old_entry))
+        self(self, dependency->first);
+    if (new_entry)
+      for (auto const *dependency : after_query.dependencies(*new_entry))
+        self(self, dependency->first);
+  };
+
+  // Roots are the entries only used from within their own cycle, if at all.
+  auto is_root = [](query_t const &query, merkle_t const &hashes, query_t::entry_t const &entry) {
+    auto const &users = query.users(entry);
+    return std::all_of(users.begin(), users.end(), [&](auto const *user) {
+      return hashes.component(*user) == hashes.component(entry);
+    });
+  };
+  for (auto const *entry : before_query.entries())
+    if (is_root(before_query, before_hashes, *entry))
+      visit(visit, entry->first);
+  for (auto const *entry : after_query.entries())
+    if (is_root(after_query, after_hashes, *entry))
+      visit(visit, entry->first);
+
+  std::sort(output.added.begin(), output.added.end());
+  std::sort(output.removed.begin(), output.removed.end());
+  std::sort(output.changed.begin(), output.changed.end());
+  return output;
+}
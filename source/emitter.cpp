@@ -0,0 +1,858 @@
+﻿// Copyright (c) 2021 Cvelth <cvelth.mail@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <utility>
+
+#include "async.hpp"
+#include "emitter.hpp"
+#include "query.hpp"
+using namespace std::literals;
+
+void vkma_xml::detail::xml_emitter_t::append_typename(pugi::xml_node &xml,
+                                                      decorated_typename_t const &type) {
+  xml.append_child(pugi::node_pcdata).set_value(type.prefix().data());
+  xml.append_child("type").append_child(pugi::node_pcdata).set_value(type.name().data());
+  xml.append_child(pugi::node_pcdata).set_value(type.postfix().data());
+}
+
+vkma_xml::detail::xml_emitter_t::xml_emitter_t()
+  : output(std::make_optional<pugi::xml_document>()) {}
+
+void vkma_xml::detail::xml_emitter_t::begin() {
+  registry = output->append_child("registry");
+  registry.append_child("comment")
+    .append_child(pugi::node_pcdata)
+    .set_value("\nCopyright (c) 2021 Cvelth (cvelth.mail@gmail.com)"
+               "\nSPDX-License-Identifier: Unlicense.");
+  registry.append_child("comment")
+    .append_child(pugi::node_pcdata)
+    .set_value(
+      "\nDO NOT MODIFY MANUALLY!"
+      "\nThis file was generated using [generator](https://github.com/Cvelth/vkma_xml_generator)."
+      "\nGenerated files are licensed under [The Unlicense](https://unlicense.org)."
+      "\nThe generator itself is licensed under [MIT "
+      "License](https://www.mit.edu/~amini/LICENSE.md).");
+  registry.append_child("comment")
+    .append_child(pugi::node_pcdata)
+    .set_value(
+      "\nThis file was generated from xml 'doxygen' documentation for "
+      "[vkma_bindings.hpp](https://github.com/Cvelth/vkma_bindings/blob/main/include/"
+      "vkma_bindings.hpp) "
+      "header."
+      "\nHeaders used for name lookup: "
+      "\n[vk_mem_alloc.h "
+      "(VulkanMemoryAllocator)](https://github.com/GPUOpen-LibrariesAndSDKs/"
+      "VulkanMemoryAllocator/blob/master/include/vk_mem_alloc.h) "
+      "\n[vulkan_core.h "
+      "(Vulkan-Headers)](https://github.com/KhronosGroup/Vulkan-Headers/blob/master/include/"
+      "vulkan/vulkan_core.h) "
+      "\n\nIt is intended to be used as [vulkan-hpp "
+      "fork](https://github.com/Cvelth/vkma_vulkan_hpp_fork) generator input."
+      "\nThe goal is to generate a "
+      "[vulkan-hpp](https://github.com/KhronosGroup/Vulkan-Hpp/blob/master/vulkan/vulkan.hpp) "
+      "compatible header - a better c++ interface for VulkanMemoryAllocator.");
+
+  auto platforms = registry.append_child("platforms");
+  platforms.append_attribute("comment").set_value("empty");
+  auto platform = platforms.append_child("platform");
+  platform.append_attribute("name").set_value("does_not_matter");
+  platform.append_attribute("protect").set_value("VKMA_DOES_NOT_MATTER");
+  platform.append_attribute("comment").set_value("Why am I even required to specify this?");
+
+  auto tags = registry.append_child("tags");
+  tags.append_attribute("comment").set_value("empty");
+  auto tag = tags.append_child("tag");
+  tag.append_attribute("name").set_value("WC");
+  tag.append_attribute("author").set_value("Who cares?");
+  tag.append_attribute("contact").set_value("@cvelth");
+}
+void vkma_xml::detail::xml_emitter_t::end() {
+  auto extensions = registry.append_child("extensions");
+  extensions.append_attribute("comment").set_value("empty");
+  auto extension = extensions.append_child("extension");
+  extension.append_attribute("name").set_value("VK_WC_why_y_y_y_y");
+  extension.append_attribute("number").set_value("1");
+  extension.append_attribute("type").set_value("instance");
+  extension.append_attribute("author").set_value("WC");
+  extension.append_attribute("contact").set_value("@cvelth");
+  extension.append_attribute("supported").set_value("disabled");
+  auto spirvextensions = registry.append_child("spirvextensions");
+  spirvextensions.append_attribute("comment").set_value("empty");
+  auto spirvcapabilities = registry.append_child("spirvcapabilities");
+  spirvcapabilities.append_attribute("comment").set_value("empty");
+}
+
+void vkma_xml::detail::xml_emitter_t::begin_types() {
+  types = registry.append_child("types");
+  types.append_attribute("comment").set_value("VKMA type definitions");
+
+  auto required_comment = types.append_child("comment");
+  required_comment.append_child(pugi::node_pcdata).set_value("Why is a comment here required?!");
+
+  auto vma_include = types.append_child("type");
+  vma_include.append_attribute("name").set_value("vma");
+  vma_include.append_attribute("category").set_value("include");
+  vma_include.append_child(pugi::node_pcdata).set_value("#include \"vk_mem_alloc.h\"");
+}
+void vkma_xml::detail::xml_emitter_t::append_basetype(std::string_view keyword,
+                                                      std::string_view name) {
+  auto type = types.append_child("type");
+  type.append_attribute("category").set_value("basetype");
+  if (!keyword.empty())
+    type.append_child(pugi::node_pcdata).set_value((std::string(keyword) + " ").data());
+  type.append_child("name").append_child(pugi::node_pcdata).set_value(std::string(name).data());
+  if (!keyword.empty())
+    type.append_child(pugi::node_pcdata).set_value(";");
+}
+void vkma_xml::detail::xml_emitter_t::append_typedef(std::string_view name,
+                                                     decorated_typename_t const &real_type) {
+  auto type = types.append_child("type");
+  type.append_attribute("category").set_value("basetype");
+  type.append_child(pugi::node_pcdata).set_value("typedef ");
+  append_typename(type, real_type);
+  type.append_child(pugi::node_pcdata).set_value(" ");
+  type.append_child("name").append_child(pugi::node_pcdata).set_value(std::string(name).data());
+  type.append_child(pugi::node_pcdata).set_value(";");
+}
+void vkma_xml::detail::xml_emitter_t::append_bitmask(std::string_view name,
+                                                     std::optional<std::string_view> bits,
+                                                     bool is_64bit) {
+  auto type = types.append_child("type");
+  type.append_attribute("category").set_value("bitmask");
+  // Same as 'vk.xml': 64-bit flag bits are not an enum type to require.
+  type.append_attribute(is_64bit ? "bitvalues" : "requires")
+    .set_value(bits ? std::string(*bits).data() : "none");
+  type.append_child(pugi::node_pcdata).set_value("typedef ");
+  type.append_child("type").append_child(pugi::node_pcdata).set_value(is_64bit ? "VkFlags64"
+                                                                               : "VkFlags");
+  type.append_child(pugi::node_pcdata).set_value(" ");
+  type.append_child("name").append_child(pugi::node_pcdata).set_value(std::string(name).data());
+  type.append_child(pugi::node_pcdata).set_value(";");
+}
+void vkma_xml::detail::xml_emitter_t::append_define(std::string_view name,
+                                                    std::string_view value) {
+  auto type = types.append_child("type");
+  type.append_attribute("category").set_value("define");
+  type.append_child(pugi::node_pcdata).set_value("#define ");
+  type.append_child("name").append_child(pugi::node_pcdata).set_value(std::string(name).data());
+  type.append_child(pugi::node_pcdata).set_value((" " + std::string(value)).data());
+}
+void vkma_xml::detail::xml_emitter_t::append_enum_type(std::string_view name) {
+  auto type = types.append_child("type");
+  type.append_attribute("name").set_value(std::string(name).data());
+  type.append_attribute("category").set_value("enum");
+}
+void vkma_xml::detail::xml_emitter_t::append_handle(std::string_view name,
+                                                    type::handle const &handle,
+                                                    std::string_view objtypeenum) {
+  auto type = types.append_child("type");
+  type.append_attribute("category").set_value("handle");
+  if (handle.parent)
+    type.append_attribute("parent").set_value(handle.parent->data());
+  type.append_attribute("objtypeenum").set_value(std::string(objtypeenum).data());
+  if (handle.dispatchable)
+    type.append_child("type").append_child(pugi::node_pcdata).set_value("VK_DEFINE_HANDLE");
+  else
+    type.append_child("type")
+      .append_child(pugi::node_pcdata)
+      .set_value("VK_DEFINE_NON_DISPATCHABLE_HANDLE");
+  type.append_child(pugi::node_pcdata).set_value("(");
+  type.append_child("name").append_child(pugi::node_pcdata).set_value(std::string(name).data());
+  type.append_child(pugi::node_pcdata).set_value(")");
+}
+void vkma_xml::detail::xml_emitter_t::append_struct(std::string_view name,
+                                                    type::structure const &structure) {
+  auto type = types.append_child("type");
+  type.append_attribute("category").set_value(structure.is_union ? "union" : "struct");
+  type.append_attribute("name").set_value(std::string(name).data());
+  for (auto &member : *structure.members) {
+    auto output = type.append_child("member");
+    append_typename(output, member.type);
+    output.append_child(pugi::node_pcdata).set_value(" ");
+    output.append_child("name").append_child(pugi::node_pcdata).set_value(member.name.data());
+    if (member.array) {
+      output.append_child(pugi::node_pcdata).set_value("[");
+      output.append_child("enum").append_child(pugi::node_pcdata).set_value(member.array->data());
+      output.append_child(pugi::node_pcdata).set_value("]");
+    }
+  }
+}
+void vkma_xml::detail::xml_emitter_t::append_funcpointer(
+  std::string_view name, type::function_pointer const &function_pointer) {
+  auto type = types.append_child("type");
+  type.append_attribute("category").set_value("funcpointer");
+  type.append_child(pugi::node_pcdata)
+    .set_value(("typedef " + function_pointer.return_type.to_string() + "(*").data());
+  type.append_child("name").append_child(pugi::node_pcdata).set_value(std::string(name).data());
+  if (function_pointer.parameters.empty()) {
+    type.append_child(pugi::node_pcdata).set_value(")(void);");
+    return;
+  }
+  type.append_child(pugi::node_pcdata).set_value(")(");
+  for (auto iterator = function_pointer.parameters.begin();
+       iterator != std::prev(function_pointer.parameters.end()); ++iterator) {
+    append_typename(type, iterator->type);
+    type.append_child(pugi::node_pcdata).set_value((" " + iterator->name + ", ").data());
+  }
+  append_typename(type, function_pointer.parameters.back().type);
+  type.append_child(pugi::node_pcdata)
+    .set_value((" " + function_pointer.parameters.back().name + ");").data());
+}
+
+void vkma_xml::detail::xml_emitter_t::begin_enumerations() {
+  constants = registry.append_child("enums");
+  constants.append_attribute("name").set_value("API Constants");
+  constants.append_attribute("comment").set_value(
+    "Hardcoded constants - not an enumerated type, part of the header boilerplate");
+}
+void vkma_xml::detail::xml_emitter_t::append_constant(std::string_view name,
+                                                      std::string_view value) {
+  auto enum_ = constants.append_child("enum");
+  enum_.append_attribute("value").set_value(std::string(value).data());
+  enum_.append_attribute("name").set_value(std::string(name).data());
+}
+void vkma_xml::detail::xml_emitter_t::append_enumeration(std::string_view name,
+                                                         type::enumeration const &enumeration,
+                                                         bool is_bitmask, bool is_64bit) {
+  auto enums = registry.append_child("enums");
+  enums.append_attribute("name").set_value(std::string(name).data());
+  if (is_bitmask) {
+    enums.append_attribute("type").set_value("bitmask");
+    if (is_64bit)
+      enums.append_attribute("bitwidth").set_value("64");
+  } else
+    enums.append_attribute("type").set_value("enum");
+  for (auto &enumerator : enumeration.values) {
+    auto enum_ = enums.append_child("enum");
+    enum_.append_attribute("value").set_value(enumerator.value.data());
+    enum_.append_attribute("name").set_value(enumerator.name.data());
+  }
+  for (auto &alias : enumeration.aliases) {
+    auto enum_ = enums.append_child("enum");
+    enum_.append_attribute("name").set_value(alias.name.data());
+    enum_.append_attribute("alias").set_value(alias.value.data());
+  }
+}
+
+void vkma_xml::detail::xml_emitter_t::begin_commands() {
+  commands = registry.append_child("commands");
+  commands.append_attribute("comment").set_value("VKMA command definitions");
+}
+void vkma_xml::detail::xml_emitter_t::append_command(std::string_view name,
+                                                     type::function const &function,
+                                                     std::string_view success_codes,
+                                                     std::string_view error_codes) {
+  auto command = commands.append_child("command");
+  if (!success_codes.empty())
+    command.append_attribute("successcodes").set_value(std::string(success_codes).data());
+  if (!error_codes.empty())
+    command.append_attribute("errorcodes").set_value(std::string(error_codes).data());
+  auto proto = command.append_child("proto");
+  append_typename(proto, function.return_type);
+  proto.append_child(pugi::node_pcdata).set_value(" ");
+  proto.append_child("name").append_child(pugi::node_pcdata).set_value(std::string(name).data());
+
+  for (auto &parameter : *function.parameters) {
+    auto param = command.append_child("param");
+    append_typename(param, parameter.type);
+    param.append_child(pugi::node_pcdata).set_value(" ");
+    param.append_child("name").append_child(pugi::node_pcdata).set_value(parameter.name.data());
+  }
+}
+
+void vkma_xml::detail::xml_emitter_t::append_feature(appended_set_t const &appended_types,
+                                                     appended_set_t const &appended_commands) {
+  auto feature = registry.append_child("feature");
+  feature.append_attribute("api").set_value("vkma");
+  feature.append_attribute("name").set_value("VKMA_VERSION_3_0_1");
+  feature.append_attribute("number").set_value("3.0.1");
+  feature.append_attribute("comment").set_value("VKMA API interface definitions");
+
+  auto required = feature.append_child("require");
+  required.append_attribute("comment").set_value("a mess, isn't it?");
+  required.append_child("type").append_attribute("name").set_value("vma");
+
+  for (auto const &type_name : appended_types) {
+    auto type = required.append_child("type");
+    type.append_attribute("name").set_value(type_name.data());
+  }
+  for (auto const &command_name : appended_commands) {
+    auto command = required.append_child("command");
+    command.append_attribute("name").set_value(command_name.data());
+  }
+}
+
+bool vkma_xml::detail::xml_emitter_t::save(std::filesystem::path const &path) const {
+  return output && output->save_file(path.c_str());
+}
+
+static std::string print_xml(pugi::xml_node const &node, unsigned depth) {
+  std::ostringstream stream;
+  node.print(stream, "    ", pugi::format_indent, pugi::encoding_utf8, depth);
+  return stream.str();
+}
+namespace {
+  // Copies markup through unchanged, one token at a time, and lets 'insert' place text right
+  // before the token that is about to be written, on a line of its own.
+  class xml_stream_t {
+  public:
+    xml_stream_t(std::ostream &output) : output(output) {}
+
+    // Returns a complete markup token ("<...>", a comment, a processing instruction or CDATA),
+    // or an empty string once the input is over. Text before it is held back in 'text'.
+    std::string_view next(std::istream &input) {
+      markup.clear();
+      char quote = 0;
+      for (char character; input.get(character);)
+        if (markup.empty())
+          if (character == '<')
+            markup += character;
+          else
+            text += character;
+        else {
+          markup += character;
+          if (markup.starts_with("<!--")) {
+            if (markup.size() >= 7 && markup.ends_with("-->"))
+              return markup;
+          } else if (markup.starts_with("<![CDATA[")) {
+            if (markup.ends_with("]]>"))
+              return markup;
+          } else if (markup.size() < 4 && "<!--"sv.starts_with(markup)) {
+            // Not decided yet.
+          } else if (quote) {
+            if (character == quote)
+              quote = 0;
+          } else if (character == '"' || character == '\'')
+            quote = character;
+          else if (character == '>')
+            return markup;
+        }
+      return {};
+    }
+    void insert(std::string_view piece) {
+      if (piece.empty())
+        return;
+      auto line_begin = text.rfind('\n');
+      if (line_begin == std::string::npos)
+        output << text << '\n' << piece;
+      else
+        output << std::string_view(text).substr(0, line_begin + 1) << piece
+               << std::string_view(text).substr(line_begin + 1);
+      text.clear();
+    }
+    void write() {
+      output << text << markup;
+      text.clear();
+    }
+    inline std::string const &pending_text() const { return text; }
+
+  protected:
+    std::ostream &output;
+    std::string text;
+    std::string markup;
+  };
+} // namespace
+static std::string_view attribute(std::string_view markup, std::string_view name) {
+  for (size_t position = markup.find(name); position != std::string_view::npos;
+       position = markup.find(name, position + 1))
+    if (auto begin = position + name.size() + 2;
+        begin < markup.size() && markup[position - 1] == ' ' && markup[begin - 2] == '='
+        && markup[begin - 1] == '"')
+      return markup.substr(begin, markup.find('"', begin) - begin);
+  return {};
+}
+namespace {
+  // Elements of one section, printed, with the names they define.
+  struct pieces_t {
+    std::vector<std::pair<std::string, std::string>> elements;
+
+    void add(pugi::xml_node const &node, unsigned depth) {
+      std::string_view name = node.attribute("name").value();
+      if (name.empty())
+        name = node.child("name").child_value();
+      if (name.empty())
+        name = node.child("proto").child("name").child_value();
+      elements.emplace_back(name, print_xml(node, depth));
+    }
+    // Leaves out whatever upstream already defines and empties the list.
+    std::string take(vkma_xml::detail::transparent_set const &defined) {
+      std::string output;
+      for (auto const &[name, text] : elements)
+        if (!defined.contains(name))
+          output += text;
+      elements.clear();
+      return output;
+    }
+  };
+} // namespace
+bool vkma_xml::detail::merge_emitter_t::save(std::filesystem::path const &path) const {
+  if (!output)
+    return false;
+  std::ifstream input(upstream, std::ios::binary);
+  if (!input) {
+    detail::message() << "Error: Unable to read '" << std::filesystem::absolute(upstream) << "'.\n";
+    return false;
+  }
+
+  pieces_t type_pieces, constant_pieces, enum_pieces, command_pieces;
+  for (auto const &type : types.children())
+    if (type.name() != "comment"sv)
+      type_pieces.add(type, 2);
+  for (auto const &constant : constants.children())
+    constant_pieces.add(constant, 2);
+  for (auto const &enums : registry.children())
+    if (enums.name() == "enums"sv && enums != constants)
+      enum_pieces.add(enums, 1);
+  for (auto const &command : commands.children())
+    command_pieces.add(command, 2);
+  auto feature_text = print_xml(registry.child("feature"), 1);
+
+  // Names upstream defines: the registry refers to vulkan types as basetypes, those must not
+  // be defined twice.
+  transparent_set defined;
+  // Pieces that find no section of their own upstream are inserted as whole sections.
+  auto take_section = [&defined](pieces_t &pieces, pugi::xml_node const &section) {
+    auto text = pieces.take(defined);
+    if (text.empty())
+      return text;
+    std::string output = "    <"s + section.name();
+    for (auto const &attribute : section.attributes())
+      ((((output += ' ') += attribute.name()) += "=\"") += attribute.value()) += '"';
+    return ((((output += ">\n") += text) += "    </") += section.name()) += ">\n";
+  };
+
+  std::ofstream file(path, std::ios::binary);
+  xml_stream_t stream(file);
+  std::vector<std::string> open; // Names of the elements the stream is inside of.
+  auto is_inside = [&open](std::initializer_list<std::string_view> names) {
+    return std::equal(open.begin(), open.end(), names.begin(), names.end());
+  };
+  bool is_constants = false;
+  for (auto markup = stream.next(input); !markup.empty(); markup = stream.next(input)) {
+    if (markup.starts_with("<!") || markup.starts_with("<?")) {
+      // Comments, CDATA, doctype and processing instructions do not nest.
+    } else if (markup.starts_with("</")) {
+      if (is_inside({ "registry", "types", "type", "name" })
+          || is_inside({ "registry", "commands", "command", "proto", "name" }))
+        defined.emplace(stream.pending_text());
+      else if (is_inside({ "registry", "types" }))
+        stream.insert(type_pieces.take(defined));
+      else if (is_inside({ "registry", "enums" }) && is_constants)
+        stream.insert(constant_pieces.take(defined));
+      else if (is_inside({ "registry", "commands" }))
+        stream.insert(command_pieces.take(defined));
+      else if (is_inside({ "registry" })) {
+        stream.insert(take_section(type_pieces, types));
+        stream.insert(take_section(constant_pieces, constants));
+        stream.insert(enum_pieces.take(defined));
+        stream.insert(take_section(command_pieces, commands));
+        stream.insert(std::exchange(feature_text, std::string{}));
+      }
+      if (!open.empty())
+        open.pop_back();
+    } else {
+      auto name = markup.substr(1, markup.find_first_of(" \t\r\n/>") - 1);
+      if (is_inside({ "registry" })) {
+        if (name == "commands"sv) {
+          stream.insert(take_section(constant_pieces, constants));
+          stream.insert(enum_pieces.take(defined));
+        } else if (name == "extensions"sv || name == "formats"sv || name.starts_with("spirv"))
+          stream.insert(std::exchange(feature_text, std::string{}));
+        is_constants = name == "enums"sv && attribute(markup, "name") == "API Constants"sv;
+        if (name == "enums"sv)
+          defined.emplace(attribute(markup, "name"));
+      } else if (is_inside({ "registry", "types" }) || (is_inside({ "registry", "enums" })
+                                                        && is_constants))
+        if (auto defined_name = attribute(markup, "name"); !defined_name.empty())
+          defined.emplace(defined_name);
+      if (!markup.ends_with("/>"))
+        open.emplace_back(name);
+    }
+    stream.write();
+  }
+  stream.write();
+  return bool(file.flush());
+}
+
+static size_t count_nodes(pugi::xml_node const &node) {
+  size_t output = 1;
+  for (auto const &child : node.children())
+    output += count_nodes(child);
+  return output;
+}
+void vkma_xml::detail::explain_emitter_t::record(std::string_view name,
+                                                 std::string_view category,
+                                                 pugi::xml_node const &node,
+                                                 std::string_view pulled_by) {
+  std::ostringstream stream;
+  node.print(stream, "    ", pugi::format_indent, pugi::encoding_utf8, 1);
+  indices.emplace(name, records.size());
+  records.emplace_back(record_t{ std::string(name), category, std::string(pulled_by),
+                                 count_nodes(node), stream.str().size() });
+}
+
+void vkma_xml::detail::explain_emitter_t::append_basetype(std::string_view keyword,
+                                                          std::string_view name) {
+  xml_emitter_t::append_basetype(keyword, name);
+  record(name, "basetype", types.last_child(), root);
+}
+void vkma_xml::detail::explain_emitter_t::append_typedef(std::string_view name,
+                                                         decorated_typename_t const &type) {
+  xml_emitter_t::append_typedef(name, type);
+  record(name, "basetype", types.last_child(), root);
+}
+void vkma_xml::detail::explain_emitter_t::append_bitmask(std::string_view name,
+                                                         std::optional<std::string_view> bits,
+                                                         bool is_64bit) {
+  xml_emitter_t::append_bitmask(name, bits, is_64bit);
+  record(name, "bitmask", types.last_child(), root);
+}
+void vkma_xml::detail::explain_emitter_t::append_define(std::string_view name,
+                                                        std::string_view value) {
+  xml_emitter_t::append_define(name, value);
+  record(name, "define", types.last_child(), root);
+}
+void vkma_xml::detail::explain_emitter_t::append_enum_type(std::string_view name) {
+  xml_emitter_t::append_enum_type(name);
+  record(name, "enum", types.last_child(), root);
+}
+void vkma_xml::detail::explain_emitter_t::append_handle(std::string_view name,
+                                                        type::handle const &handle,
+                                                        std::string_view objtypeenum) {
+  xml_emitter_t::append_handle(name, handle, objtypeenum);
+  record(name, "handle", types.last_child(), root);
+}
+void vkma_xml::detail::explain_emitter_t::append_struct(std::string_view name,
+                                                        type::structure const &structure) {
+  xml_emitter_t::append_struct(name, structure);
+  record(name, structure.is_union ? "union" : "struct", types.last_child(), root);
+  for (auto const &member : *structure.members)
+    if (member.array)
+      arrays.try_emplace(*member.array, root);
+}
+void vkma_xml::detail::explain_emitter_t::append_funcpointer(
+  std::string_view name, type::function_pointer const &function_pointer) {
+  xml_emitter_t::append_funcpointer(name, function_pointer);
+  record(name, "funcpointer", types.last_child(), root);
+}
+
+void vkma_xml::detail::explain_emitter_t::append_constant(std::string_view name,
+                                                          std::string_view value) {
+  xml_emitter_t::append_constant(name, value);
+  auto iterator = arrays.find(name);
+  record(name, "constant", constants.last_child(),
+         iterator != arrays.end() ? std::string_view(iterator->second) : ""sv);
+}
+void vkma_xml::detail::explain_emitter_t::append_enumeration(std::string_view name,
+                                                             type::enumeration const &enumeration,
+                                                             bool is_bitmask, bool is_64bit) {
+  xml_emitter_t::append_enumeration(name, enumeration, is_bitmask, is_64bit);
+  // The values go wherever the type itself went.
+  auto iterator = indices.find(name);
+  record(name, "enums", registry.last_child(),
+         iterator != indices.end() ? std::string_view(records[iterator->second].root) : ""sv);
+}
+
+void vkma_xml::detail::explain_emitter_t::append_command(std::string_view name,
+                                                         type::function const &function,
+                                                         std::string_view success_codes,
+                                                         std::string_view error_codes) {
+  xml_emitter_t::append_command(name, function, success_codes, error_codes);
+  record(name, "command", commands.last_child(), root);
+}
+
+bool vkma_xml::detail::explain_emitter_t::save(std::filesystem::path const &path) const {
+  struct cost_t {
+    size_t elements = 0;
+    size_t nodes = 0;
+    size_t bytes = 0;
+
+    inline void add(record_t const &record) {
+      ++elements;
+      nodes += record.nodes;
+      bytes += record.bytes;
+    }
+  };
+  struct root_t {
+    std::string_view name;
+    cost_t closure;
+    cost_t first;
+  };
+
+  // Enum types and their values share a name: a closure counts both.
+  transparent_map<std::vector<record_t const *>> by_name;
+  cost_t total;
+  std::vector<root_t> roots;
+  transparent_map<size_t> root_indices;
+  for (auto const &record : records) {
+    by_name[record.name].emplace_back(&record);
+    total.add(record);
+    if (!record.root.empty()) {
+      auto [iterator, inserted] = root_indices.try_emplace(record.root, roots.size());
+      if (inserted)
+        roots.emplace_back(root_t{ record.root, {}, {} });
+      roots[iterator->second].first.add(record);
+    }
+  }
+  // 'query_t' follows the same edges as the generator, array sizes included.
+  query_t const query(api);
+  for (auto &root : roots)
+    for (auto const *entry : query.closure(root.name))
+      if (auto iterator = by_name.find(entry->first); iterator != by_name.end())
+        for (auto const *record : iterator->second)
+          root.closure.add(*record);
+  std::stable_sort(roots.begin(), roots.end(), [](root_t const &left, root_t const &right) {
+    return left.closure.bytes > right.closure.bytes;
+  });
+
+  std::ofstream file(path);
+  if (!file)
+    return false;
+  file << total.elements << " elements, " << total.nodes << " nodes, " << total.bytes
+       << " bytes.\n\n";
+  file << "Roots by the size of their closure (elements nodes bytes), then of the part they "
+          "pulled in first:\n";
+  for (auto const &root : roots)
+    file << std::setw(6) << root.closure.elements << std::setw(8) << root.closure.nodes
+         << std::setw(10) << root.closure.bytes << " |" << std::setw(6) << root.first.elements
+         << std::setw(8) << root.first.nodes << std::setw(10) << root.first.bytes << "  "
+         << root.name << '\n';
+  file << "\nElements in the output order (nodes bytes), with the root that pulled them in:\n";
+  for (auto const &record : records)
+    file << std::setw(8) << record.nodes << std::setw(10) << record.bytes << "  "
+         << std::left << std::setw(12) << record.category << std::right << record.name
+         << (record.root.empty() ? "" : " <- ") << record.root << '\n';
+  return bool(file.flush());
+}
+
+static void append_string(std::string &output, std::string_view value) {
+  output += '"';
+  for (char character : value)
+    if (character == '"' || character == '\\')
+      (output += '\\') += character;
+    else if (character == '\n')
+      output += "\\n";
+    else if (character == '\t')
+      output += "\\t";
+    else if (static_cast<unsigned char>(character) < 0x20) {
+      constexpr std::string_view digits = "0123456789abcdef";
+      (output += "\\u00") += digits[character >> 4];
+      output += digits[character & 0xf];
+    } else
+      output += character;
+  output += '"';
+}
+static std::string &begin_element(std::string &section, std::string_view category) {
+  if (!section.empty())
+    section += ',';
+  if (category.empty())
+    section += '{';
+  else {
+    section += "{\"category\":";
+    append_string(section, category);
+    section += ',';
+  }
+  return section;
+}
+static void append_field(std::string &output, std::string_view key, std::string_view value,
+                         bool comma = true) {
+  append_string(output, key);
+  output += ':';
+  append_string(output, value);
+  if (comma)
+    output += ',';
+}
+// 'cache' holds the rendered object of every type id seen so far, empty for the ones not yet seen.
+static void append_typename(std::string &output, std::vector<std::string> &cache,
+                            std::string_view key,
+                            vkma_xml::detail::decorated_typename_t const &type) {
+  if (type.id() >= cache.size())
+    cache.resize(type.id() + 1);
+  if (auto &rendered = cache[type.id()]; rendered.empty()) {
+    rendered += '{';
+    if (!type.prefix().empty())
+      append_field(rendered, "prefix", type.prefix());
+    if (!type.postfix().empty())
+      append_field(rendered, "postfix", type.postfix());
+    append_field(rendered, "name", type.name(), false);
+    rendered += '}';
+  }
+  append_string(output, key);
+  ((output += ':') += cache[type.id()]) += ',';
+}
+static void append_variables(std::string &output, std::vector<std::string> &cache,
+                             std::string_view key,
+                             std::vector<vkma_xml::detail::variable_t> const &variables) {
+  append_string(output, key);
+  output += ":[";
+  for (auto iterator = variables.begin(); iterator != variables.end(); ++iterator) {
+    if (iterator != variables.begin())
+      output += ',';
+    output += '{';
+    append_typename(output, cache, "type", iterator->type);
+    if (iterator->array)
+      append_field(output, "enum", *iterator->array);
+    append_field(output, "name", iterator->name, false);
+    output += '}';
+  }
+  output += "],";
+}
+
+void vkma_xml::detail::json_emitter_t::begin() {
+  // Ids are only unique within a table, the next api may use another one.
+  typenames.clear();
+  output.clear();
+  types.clear();
+  constants.clear();
+  enums.clear();
+  commands.clear();
+  feature.clear();
+}
+void vkma_xml::detail::json_emitter_t::end() {
+  output.reserve(types.size() + constants.size() + enums.size() + commands.size()
+                 + feature.size() + 64);
+  ((output = "{\"types\":[") += types) += "],";
+  ((output += "\"constants\":[") += constants) += "],";
+  ((output += "\"enums\":[") += enums) += "],";
+  ((output += "\"commands\":[") += commands) += "],";
+  ((output += "\"feature\":") += feature.empty() ? "null"sv : feature) += "}";
+}
+
+void vkma_xml::detail::json_emitter_t::append_basetype(std::string_view keyword,
+                                                       std::string_view name) {
+  auto &output = begin_element(types, "basetype");
+  if (!keyword.empty())
+    append_field(output, "keyword", keyword);
+  append_field(output, "name", name, false);
+  output += '}';
+}
+void vkma_xml::detail::json_emitter_t::append_typedef(std::string_view name,
+                                                      decorated_typename_t const &type) {
+  auto &output = begin_element(types, "basetype");
+  append_typename(output, typenames, "type", type);
+  append_field(output, "name", name, false);
+  output += '}';
+}
+void vkma_xml::detail::json_emitter_t::append_bitmask(std::string_view name,
+                                                      std::optional<std::string_view> bits,
+                                                      bool is_64bit) {
+  auto &output = begin_element(types, "bitmask");
+  append_field(output, is_64bit ? "bitvalues"sv : "requires"sv, bits ? *bits : "none"sv);
+  if (is_64bit)
+    output += "\"bitwidth\":64,";
+  append_field(output, "name", name, false);
+  output += '}';
+}
+void vkma_xml::detail::json_emitter_t::append_define(std::string_view name,
+                                                     std::string_view value) {
+  auto &output = begin_element(types, "define");
+  append_field(output, "value", value);
+  append_field(output, "name", name, false);
+  output += '}';
+}
+void vkma_xml::detail::json_emitter_t::append_enum_type(std::string_view name) {
+  auto &output = begin_element(types, "enum");
+  append_field(output, "name", name, false);
+  output += '}';
+}
+void vkma_xml::detail::json_emitter_t::append_handle(std::string_view name,
+                                                     type::handle const &handle,
+                                                     std::string_view objtypeenum) {
+  auto &output = begin_element(types, "handle");
+  if (handle.parent)
+    append_field(output, "parent", *handle.parent);
+  append_field(output, "objtypeenum", objtypeenum);
+  append_field(output, "type",
+               handle.dispatchable ? "VK_DEFINE_HANDLE"sv : "VK_DEFINE_NON_DISPATCHABLE_HANDLE"sv);
+  append_field(output, "name", name, false);
+  output += '}';
+}
+void vkma_xml::detail::json_emitter_t::append_struct(std::string_view name,
+                                                     type::structure const &structure) {
+  auto &output = begin_element(types, structure.is_union ? "union" : "struct");
+  append_variables(output, typenames, "members", *structure.members);
+  append_field(output, "name", name, false);
+  output += '}';
+}
+void vkma_xml::detail::json_emitter_t::append_funcpointer(
+  std::string_view name, type::function_pointer const &function_pointer) {
+  auto &output = begin_element(types, "funcpointer");
+  append_typename(output, typenames, "return", function_pointer.return_type);
+  append_variables(output, typenames, "params", function_pointer.parameters);
+  append_field(output, "name", name, false);
+  output += '}';
+}
+
+void vkma_xml::detail::json_emitter_t::append_constant(std::string_view name,
+                                                       std::string_view value) {
+  auto &output = begin_element(constants, "");
+  append_field(output, "value", value);
+  append_field(output, "name", name, false);
+  output += '}';
+}
+void vkma_xml::detail::json_emitter_t::append_enumeration(std::string_view name,
+                                                          type::enumeration const &enumeration,
+                                                          bool is_bitmask, bool is_64bit) {
+  auto &output = begin_element(enums, "");
+  append_field(output, "type", is_bitmask ? "bitmask"sv : "enum"sv);
+  if (is_64bit)
+    output += "\"bitwidth\":64,";
+  output += "\"values\":[";
+  for (auto iterator = enumeration.values.begin(); iterator != enumeration.values.end();
+       ++iterator) {
+    output += iterator == enumeration.values.begin() ? "{" : ",{";
+    append_field(output, "value", iterator->value);
+    append_field(output, "name", iterator->name, false);
+    output += '}';
+  }
+  output += "],\"aliases\":[";
+  for (auto iterator = enumeration.aliases.begin(); iterator != enumeration.aliases.end();
+       ++iterator) {
+    output += iterator == enumeration.aliases.begin() ? "{" : ",{";
+    append_field(output, "alias", iterator->value);
+    append_field(output, "name", iterator->name, false);
+    output += '}';
+  }
+  output += "],";
+  append_field(output, "name", name, false);
+  output += '}';
+}
+
+void vkma_xml::detail::json_emitter_t::append_command(std::string_view name,
+                                                      type::function const &function,
+                                                      std::string_view success_codes,
+                                                      std::string_view error_codes) {
+  auto &output = begin_element(commands, "");
+  if (!success_codes.empty())
+    append_field(output, "successcodes", success_codes);
+  if (!error_codes.empty())
+    append_field(output, "errorcodes", error_codes);
+  append_typename(output, typenames, "return", function.return_type);
+  append_variables(output, typenames, "params", *function.parameters);
+  append_field(output, "name", name, false);
+  output += '}';
+}
+
+void vkma_xml::detail::json_emitter_t::append_feature(appended_set_t const &appended_types,
+                                                      appended_set_t const &appended_commands) {
+  feature = "{";
+  append_field(feature, "api", "vkma");
+  append_field(feature, "name", "VKMA_VERSION_3_0_1");
+  append_field(feature, "number", "3.0.1");
+  feature += "\"types\":[\"vma\"";
+  for (auto const &type_name : appended_types)
+    append_string(feature += ',', type_name);
+  feature += "],\"commands\":[";
+  for (auto iterator = appended_commands.begin(); iterator != appended_commands.end();
+       ++iterator)
+    append_string(iterator == appended_commands.begin() ? feature : feature += ',', *iterator);
+  feature += "]}";
+}
+
+bool vkma_xml::detail::json_emitter_t::save(std::filesystem::path const &path) const {
+  std::ofstream stream(path, std::ios::binary);
+  return stream && stream.write(output.data(), output.size());
+}
@@ -1,36 +1,70 @@
 ﻿// Copyright (c) 2021 Cvelth <cvelth.mail@gmail.com>
 // SPDX-License-Identifier: MIT
 
+#include <algorithm>
+#include <charconv>
 #include <chrono>
+#include <deque>
 #include <iostream>
+#include <locale>
+#include <memory>
 #include <set>
 #include <string_view>
+#include <utility>
 #include <vector>
 
+#include "async.hpp"
+#include "diff.hpp"
+#include "emitter.hpp"
 #include "generator.hpp"
+#include "query.hpp"
+#include "shard.hpp"
+#include "task_graph.hpp"
+#include "trace.hpp"
 using namespace std::literals;
 
 std::optional<pugi::xml_document> vkma_xml::detail::load_xml(std::filesystem::path const &file) {
+  detail::trace_span_t span("load_xml");
+  if (span)
+    span.arg("file", file.string());
   auto output = std::make_optional<pugi::xml_document>();
   if (auto result = output->load_file(file.c_str()); result)
     return output;
   else
-    std::cout << "Error: Fail to load '" << std::filesystem::absolute(file)
-              << "': " << result.description() << '\n';
+    detail::message() << "Error: Fail to load '" << std::filesystem::absolute(file)
+                      << "': " << result.description() << '\n';
+  return std::nullopt;
+}
+std::optional<pugi::xml_document> vkma_xml::detail::load_xml(std::string_view source,
+                                                             std::filesystem::path const &file) {
+  auto output = std::make_optional<pugi::xml_document>();
+  if (auto result = output->load_buffer(source.data(), source.size()); result)
+    return output;
+  else
+    detail::message() << "Error: Fail to load '" << std::filesystem::absolute(file)
+                      << "': " << result.description() << '\n';
   return std::nullopt;
 }
 
-inline vkma_xml::detail::type_registry::underlying_t::iterator
+vkma_xml::detail::type_registry::underlying_t::iterator
 vkma_xml::detail::type_registry::get(identifier_t &&name) {
   auto [iterator, result] = underlying.try_emplace(std::move(name),
                                                    type_t{ type::undefined{}, type_tag::helper });
+  if (result) {
+    iterator->second.index = ordered.size();
+    ordered.emplace_back(&*iterator);
+  }
   return iterator;
 }
-inline vkma_xml::detail::type_registry::underlying_t::iterator
+vkma_xml::detail::type_registry::underlying_t::iterator
 vkma_xml::detail::type_registry::add(identifier_t &&name, type_t &&type_data) {
+  type_data.index = ordered.size();
   auto [iterator, result] = underlying.try_emplace(std::move(name), std::move(type_data));
 
-  if (!result)
+  if (result)
+    ordered.emplace_back(&*iterator);
+  else {
+    type_data.index = iterator->second.index;
     if (std::holds_alternative<type::undefined>(iterator->second.state))
       iterator->second = std::move(type_data);
     else if (std::holds_alternative<type::structure>(iterator->second.state)
@@ -39,19 +73,22 @@ vkma_xml::detail::type_registry::add(identifier_t &&name, type_t &&type_data) {
         type_data.tag = type_tag::core;
       iterator->second = std::move(type_data);
     } else {
-      std::cout << "Warning: Attempt to define a typename '" << iterator->first
-                << "' more than once: second definition ignored.\n";
+      detail::message() << "Warning: Attempt to define a typename '" << iterator->first
+                        << "' more than once: second definition ignored.\n";
       return iterator;
     }
+  }
 
   struct on_add_visitor {
     vkma_xml::detail::type_registry &registry_ref;
     identifier_t const &name_ref;
 
     void operator()(type::undefined const &) {}
+    // Undecoded members and parameters are not mentioned: nothing has looked at them yet.
     void operator()(type::structure const &structure) {
-      for (auto const &member : structure.members)
-        registry_ref.get(member.type.name);
+      if (structure.members.is_decoded())
+        for (auto const &member : *structure.members)
+          registry_ref.get(member.type.name());
     }
     void operator()(type::handle const &) {
       if (auto iterator = registry_ref.find(name_ref + "_T");
@@ -61,52 +98,130 @@ vkma_xml::detail::type_registry::add(identifier_t &&name, type_t &&type_data) {
     void operator()(type::macro const &) {}
     void operator()(type::enumeration const &enumeration) {
       if (enumeration.type)
-        registry_ref.get(enumeration.type->name);
+        registry_ref.get(enumeration.type->name());
     }
     void operator()(type::function const &function) {
-      registry_ref.get(function.return_type.name);
-      for (auto const &parameter : function.parameters)
-        registry_ref.get(parameter.type.name);
+      registry_ref.get(function.return_type.name());
+      if (function.parameters.is_decoded())
+        for (auto const &parameter : *function.parameters)
+          registry_ref.get(parameter.type.name());
     }
     void operator()(type::function_pointer const &function_pointer) {
-      registry_ref.get(function_pointer.return_type.name);
+      registry_ref.get(function_pointer.return_type.name());
       for (auto const &parameter : function_pointer.parameters)
-        registry_ref.get(parameter.type.name);
+        registry_ref.get(parameter.type.name());
     }
-    void operator()(type::alias const alias) { registry_ref.get(alias.real_type.name); }
+    void operator()(type::alias const alias) { registry_ref.get(alias.real_type.name()); }
     void operator()(type::base const &) {}
   };
   std::visit(on_add_visitor{ *this, iterator->first }, iterator->second.state);
   return iterator;
 }
+void vkma_xml::detail::type_registry::reindex() {
+  ordered.resize(underlying.size());
+  for (auto &entry : underlying)
+    ordered[entry.second.index] = &entry;
+}
 
-static std::string optimize(std::string &&input) {
-  static std::locale locale("en_US.UTF8");
+void vkma_xml::detail::sharded_registry_t::insert(record_t &&record) {
+  auto &shard = shards[transparent_hash_t{}(record.name) % shards.size()];
+  std::lock_guard lock(shard.mutex);
+  shard.records.emplace_back(std::move(record));
+}
+void vkma_xml::detail::sharded_registry_t::add(sequence_t sequence, identifier_t &&name,
+                                               type_t &&type_data) {
+  insert(record_t{ sequence, std::move(name), std::move(type_data) });
+}
+void vkma_xml::detail::sharded_registry_t::get(sequence_t sequence, identifier_t &&name) {
+  insert(record_t{ sequence, std::move(name), std::nullopt });
+}
+void vkma_xml::detail::sharded_registry_t::merge(api_t &output) {
+  trace_span_t span("sharded_registry_t::merge");
+  std::vector<record_t> records;
+  for (auto &shard : shards) {
+    std::lock_guard lock(shard.mutex);
+    records.insert(records.end(), std::make_move_iterator(shard.records.begin()),
+                   std::make_move_iterator(shard.records.end()));
+    shard.records.clear();
+  }
+  std::sort(records.begin(), records.end(),
+            [](record_t const &left, record_t const &right) {
+              return left.sequence < right.sequence;
+            });
+  for (auto &record : records)
+    if (record.type_data)
+      output.add(std::move(record.name), std::move(*record.type_data));
+    else
+      output.get(std::move(record.name));
+}
 
-  std::string output;
-  output.reserve(input.size());
-  for (size_t i = 0; i < input.size(); ++i)
-    if (input[i] == '\n') {
-      input[i] = ' ';
-      --i;
-    } else if (i != 0 && std::isblank(input[i], locale) && std::isblank(input[i - 1], locale)) {
-      // Skip consecutive blank characters.
-    } else
-      output += input[i];
-  return output;
+void vkma_xml::detail::registry_journal_t::replay(type_registry &output) {
+  trace_span_t span("registry_journal_t::replay");
+  for (auto &[name, type_data] : records)
+    if (type_data)
+      output.add(std::move(name), std::move(*type_data));
+    else
+      output.get(std::move(name));
+  records.clear();
+}
+void vkma_xml::detail::registry_journal_t::replay(api_t &output) {
+  for (auto &[name, type_data] : records)
+    if (type_data)
+      output.add(std::move(name), std::move(*type_data));
+    else
+      output.get(std::move(name));
+  records.clear();
+}
+
+static std::string optimize(std::string &&input) {
+  // Identifiers are ascii: the classic locale classifies them the same way any other one would,
+  // and, unlike a named one, it needs no construction and is never shared mutable state.
+  auto const &locale = std::locale::classic();
+
+  // A single pass, compacted in place: a character is only ever written over itself or one
+  // already read. A newline counts as a space.
+  size_t size = 0;
+  char previous = '\0';
+  for (auto character : input) {
+    if (character == '\n')
+      character = ' ';
+    if (!std::isblank(character, locale) || !std::isblank(previous, locale))
+      input[size++] = character;
+    previous = character;
+  }
+  input.resize(size);
+  return std::move(input);
 }
 static std::string to_string(pugi::xml_node const &xml) {
+  // Sized up front: a type split by '<ref>'s would otherwise grow once per piece.
+  size_t size = 0;
+  for (auto &child : xml.children())
+    if (child.type() == pugi::xml_node_type::node_pcdata)
+      size += std::char_traits<char>::length(child.value());
+    else if (child.name() == "ref"sv)
+      size += std::char_traits<char>::length(child.child_value());
+
   std::string output;
+  output.reserve(size);
   for (auto &child : xml.children())
     if (child.type() == pugi::xml_node_type::node_pcdata)
       output += child.value();
     else if (child.name() == "ref"sv)
       output += child.child_value();
     else
-      std::cout << "Warning: Ignore an unknown tag: '" << child.name() << "'.\n";
+      vkma_xml::detail::message() << "Warning: Ignore an unknown tag: '" << child.name() << "'.\n";
   return optimize(std::move(output));
 }
 
+// Lets the containers filled from 'xml' be allocated once.
+static size_t count_children(pugi::xml_node const &xml, std::string_view name) {
+  size_t output = 0;
+  for (auto &child : xml.children())
+    if (child.name() == name)
+      ++output;
+  return output;
+}
+
 static std::string trim(std::string &&input) {
   auto begin = input.find_first_not_of(' ');
   if (begin == std::string::npos)
@@ -114,88 +229,305 @@ static std::string trim(std::string &&input) {
   auto end = input.find_last_not_of(' ');
   if (end == std::string::npos)
     end = input.size();
-  return input.substr(begin, end - begin + 1);
-}
-vkma_xml::detail::decorated_typename_t::decorated_typename_t(std::string input) : name(input) {
-  bool changed = false;
-  do {
-    changed = false;
-    for (auto const &token : accepted_prefixes)
-      if (name.size() > token.size() && std::string_view(name).substr(0, token.size()) == token) {
-        prefix += std::string_view(name).substr(0, token.size());
-        name.erase(0, token.size());
-        changed = true;
-      }
-  } while (changed);
-  do {
-    changed = false;
-    for (auto const &token : accepted_postfixes)
-      if (size_t position = name.size() - token.size();
-          name.size() > token.size() && std::string_view(name).substr(position) == token) {
-        postfix.insert(0, std::string_view(name).substr(position));
-        name.erase(position, token.size());
-        changed = true;
-      }
-  } while (changed);
-  prefix = trim(std::move(prefix));
-  postfix = trim(std::move(postfix));
+  input.resize(std::min(input.size(), end + 1));
+  input.erase(0, begin);
+  return std::move(input);
 }
+static vkma_xml::detail::typename_entry_t const empty_typename{ "", "", "", "", 0 };
+// Split into shards by the hash of the key, so that concurrent loaders rarely wait for each other.
+class vkma_xml::detail::typename_table_t
+  : public std::enable_shared_from_this<vkma_xml::detail::typename_table_t> {
+public:
+  static constexpr size_t shard_count = 64;
+  struct shard_t {
+    std::mutex mutex;
+    std::deque<typename_entry_t> entries;
+    // Keyed by the raw text, so that a repeated spelling is split only once.
+    transparent_map<typename_entry_t const *> by_input;
+    // Keyed by 'prefix \n name \n postfix', so that differently spaced inputs share an entry.
+    transparent_map<typename_entry_t const *> by_parts;
+  };
 
+  typename_table_t() : generation(++generations) {}
+
+  std::array<shard_t, shard_count> shards;
+  std::atomic<std::uint32_t> count = 1; // The next id.
+  std::uint64_t const generation;       // Tells the per thread caches a table from another.
+  inline static std::atomic<std::uint64_t> generations = 0;
+};
+namespace {
+  // At most one table is alive at a time: a new one is only made once the last one is freed.
+  std::mutex typename_table_mutex;
+  std::weak_ptr<vkma_xml::detail::typename_table_t> shared_typenames;
+  // Made while no api was alive, kept until an api takes it over.
+  std::shared_ptr<vkma_xml::detail::typename_table_t> unowned_typenames;
+
+  std::shared_ptr<vkma_xml::detail::typename_table_t> typenames() {
+    // Locking a 'weak_ptr' is safe while the table is being freed, unlike a raw pointer to it.
+    thread_local std::weak_ptr<vkma_xml::detail::typename_table_t> known;
+    if (auto table = known.lock(); table)
+      return table;
+    std::lock_guard lock(typename_table_mutex);
+    auto table = shared_typenames.lock();
+    if (!table) {
+      table = unowned_typenames = std::make_shared<vkma_xml::detail::typename_table_t>();
+      shared_typenames = table;
+    }
+    known = table;
+    return table;
+  }
+} // namespace
+std::shared_ptr<vkma_xml::detail::typename_table_t> vkma_xml::detail::share_typenames() {
+  std::lock_guard lock(typename_table_mutex);
+  auto table = shared_typenames.lock();
+  if (!table) {
+    table = std::make_shared<typename_table_t>();
+    shared_typenames = table;
+  }
+  unowned_typenames.reset();
+  return table;
+}
+
+// Owns nothing: the empty type belongs to no table.
+static std::shared_ptr<vkma_xml::detail::typename_entry_t const> empty_typename_reference() {
+  return { std::shared_ptr<void const>(), &empty_typename };
+}
+static std::shared_ptr<vkma_xml::detail::typename_entry_t const>
+make_typename(std::string input) {
+  using namespace vkma_xml::detail;
+  auto owner = typenames();
+  auto &table = *owner;
+  auto reference = [&owner](typename_entry_t const *entry) {
+    if (entry == &empty_typename)
+      return empty_typename_reference();
+    return std::shared_ptr<typename_entry_t const>(owner, entry);
+  };
+  auto input_hash = std::hash<std::string_view>{}(input);
+
+  // Most lookups repeat a recent spelling: a small cache per thread answers them without locking.
+  struct cache_t {
+    std::uint64_t generation = 0;
+    std::array<std::pair<std::string, typename_entry_t const *>, 256> slots;
+  };
+  thread_local cache_t cache;
+  if (cache.generation != table.generation) {
+    cache.slots.fill({});
+    cache.generation = table.generation;
+  }
+  auto &slot = cache.slots[input_hash % cache.slots.size()];
+  if (slot.second && slot.first == input)
+    return reference(slot.second);
+
+  auto &input_shard = table.shards[input_hash % table.shards.size()];
+  {
+    std::lock_guard guard(input_shard.mutex);
+    if (auto iterator = input_shard.by_input.find(input); iterator != input_shard.by_input.end())
+      return reference((slot = { std::move(input), iterator->second }).second);
+  }
+
+  // The name is narrowed from both ends, one token at a time, without moving any text: the
+  // prefix and the postfix are what is left on either side. No token starts (or ends) another
+  // one, so at most one of them can match at each step and the order they are tried in does
+  // not matter.
+  std::string_view name_view = input;
+  auto strip = [&name_view](auto const &tokens, bool from_front) {
+    for (bool changed = true; changed;) {
+      changed = false;
+      for (auto const &token : tokens)
+        if (name_view.size() > token.size()
+            && (from_front ? name_view.starts_with(token) : name_view.ends_with(token))) {
+          if (from_front)
+            name_view.remove_prefix(token.size());
+          else
+            name_view.remove_suffix(token.size());
+          changed = true;
+        }
+    }
+  };
+  strip(accepted_prefixes, true);
+  size_t begin = name_view.data() - input.data();
+  strip(accepted_postfixes, false);
+  size_t end = begin + name_view.size();
+
+  std::string name(name_view);
+  auto prefix = trim(input.substr(0, begin));
+  auto postfix = trim(input.substr(end));
+
+  typename_entry_t const *output = &empty_typename;
+  if (!prefix.empty() || !name.empty() || !postfix.empty()) {
+    auto parts = prefix + '\n' + name + '\n' + postfix;
+    auto &parts_shard = table.shards[std::hash<std::string>{}(parts) % table.shards.size()];
+    std::lock_guard guard(parts_shard.mutex);
+    auto [iterator, inserted] = parts_shard.by_parts.try_emplace(std::move(parts));
+    if (inserted) {
+      auto spelling = prefix + name + postfix;
+      auto id = table.count++;
+      iterator->second = &parts_shard.entries.emplace_back(typename_entry_t{
+        std::move(prefix), std::move(name), std::move(postfix), std::move(spelling), id });
+    }
+    output = iterator->second;
+  }
+  {
+    std::lock_guard guard(input_shard.mutex);
+    input_shard.by_input.try_emplace(input, output);
+  }
+  slot = { std::move(input), output };
+  return reference(output);
+}
+vkma_xml::detail::decorated_typename_t::decorated_typename_t()
+  : entry(empty_typename_reference()) {}
+vkma_xml::detail::decorated_typename_t::decorated_typename_t(std::string input)
+  : entry(make_typename(std::move(input))) {}
+size_t vkma_xml::detail::decorated_typename_t::count() {
+  std::lock_guard lock(typename_table_mutex);
+  if (auto table = shared_typenames.lock(); table)
+    return table->count;
+  return 1;
+}
+
+namespace {
+  // Doxygen element names and 'kind' values the loaders tell apart, in the order of the tables.
+  enum class element_t { type, name, enumvalue, unknown };
+  constexpr vkma_xml::detail::token_table_t<3, element_t> elements{ std::array{
+    "type"sv, "name"sv, "enumvalue"sv } };
+
+  enum class member_kind_t { define, enumeration, type_def, function, variable, unknown };
+  constexpr vkma_xml::detail::token_table_t<5, member_kind_t> member_kinds{ std::array{
+    "define"sv, "enum"sv, "typedef"sv, "function"sv, "variable"sv } };
+
+  enum class compound_kind_t { structure, union_type, file, page, dir, unknown };
+  constexpr vkma_xml::detail::token_table_t<5, compound_kind_t> compound_kinds{ std::array{
+    "struct"sv, "union"sv, "file"sv, "page"sv, "dir"sv } };
+} // namespace
+
+vkma_xml::detail::variable_t vkma_xml::detail::api_t::make_variable(identifier_t &&name,
+                                                                    std::string &&type,
+                                                                    std::string &&argsstring) {
+  if (!argsstring.empty())
+    if (argsstring.size() > 2 && argsstring.front() == '[' && argsstring.back() == ']') {
+      argsstring.pop_back();
+      argsstring.erase(0, 1);
+      return variable_t(std::move(name), std::move(type), std::move(argsstring));
+    } else
+      detail::message() << "Warning: Unable to parse 'argsstring' of a variable(" << name
+                        << "): " << argsstring << ".\n";
+  return variable_t(std::move(name), std::move(type), std::nullopt);
+}
 std::optional<vkma_xml::detail::variable_t>
 vkma_xml::detail::api_t::load_variable(pugi::xml_node const &xml) {
+  trace_span_t span("load_variable");
   if (auto name = xml.child("name"), type = xml.child("type"); name && type) {
-    if (auto argsstring = xml.child("argsstring"); argsstring)
-      if (auto str = to_string(argsstring); !str.empty())
-        if (str.size() > 2 && str.front() == '[' && str.back() == ']')
-          return std::make_optional<variable_t>(to_string(name), to_string(type),
-                                                str.substr(1, str.size() - 2));
-        else
-          std::cout << "Warning: Unable to parse 'argsstring' of a variable(" << to_string(name)
-                    << "): " << str << ".\n";
-    return std::make_optional<variable_t>(to_string(name), to_string(type), std::nullopt);
+    auto argsstring = xml.child("argsstring");
+    return make_variable(to_string(name), to_string(type),
+                         argsstring ? to_string(argsstring) : std::string{});
   }
   return std::nullopt;
 }
 std::optional<vkma_xml::detail::constant_t>
 vkma_xml::detail::api_t::load_define(pugi::xml_node const &xml) {
+  trace_span_t span("load_define");
   if (auto name = xml.child("name"), value = xml.child("initializer"); name && value)
     return std::make_optional<constant_t>(to_string(name), to_string(value));
   return std::nullopt;
 }
 std::optional<vkma_xml::detail::enum_t>
 vkma_xml::detail::api_t::load_enum(pugi::xml_node const &xml) {
+  trace_span_t span("load_enum");
   enum_t output;
+  auto enumerator_count = count_children(xml, "enumvalue");
+  output.state.values.reserve(enumerator_count);
+  output.index.reserve(enumerator_count);
   for (auto &child : xml.children())
-    if (child.name() == "type"sv)
+    switch (elements.find(child.name())) {
+    case element_t::type:
       if (auto string = to_string(child); string != "")
-        output.state.type = string;
+        output.state.type = std::move(string);
       else
         output.state.type = std::nullopt;
-    else if (child.name() == "name"sv)
-      output.name = to_string(child);
-    else if (child.name() == "enumvalue"sv)
-      if (auto name = child.child("name"), value = child.child("initializer"); name && value) {
-        auto value_str = to_string(value);
-        if (std::string_view(value_str).substr(0, 2) == "= ")
-          value_str = value_str.substr(2);
-        if (auto name_str = to_string(name);
-            std::string_view(name_str).substr(name_str.size() - 9) != "_MAX_ENUM")
-          if (std::find_if(output.state.values.begin(), output.state.values.end(),
-                           [&value_str](constant_t const &value) {
-                             return value_str == value.name;
-                           })
-              == output.state.values.end())
-            output.state.values.emplace_back(std::move(name_str), std::move(value_str));
-          else
-            output.state.aliases.emplace_back(std::move(name_str), std::move(value_str));
-      }
+      break;
+    case element_t::name: output.name = to_string(child); break;
+    case element_t::enumvalue:
+      if (auto name = child.child("name"), value = child.child("initializer"); name && value)
+        append_enumerator(output, to_string(name), to_string(value));
+      break;
+    default: break;
+    }
   if (output.name != "")
     return output;
   else
     return std::nullopt;
 }
+void vkma_xml::detail::api_t::append_enumerator(enum_t &output, identifier_t &&name,
+                                                value_t &&value) {
+  if (std::string_view(value).substr(0, 2) == "= ")
+    value.erase(0, 2);
+  if (std::string_view(name).ends_with("_MAX_ENUM"))
+    return;
+
+  auto number = evaluate_expression(
+    value, [&output](std::string_view enumerator) -> std::optional<std::int64_t> {
+      if (auto iterator = output.index.find(enumerator); iterator != output.index.end())
+        return iterator->second;
+      return std::nullopt;
+    });
+  // Only an initializer naming an earlier enumerator makes an alias, whatever its value. A name
+  // declared twice keeps its first value for lookups, both declarations are emitted.
+  bool is_alias = output.index.contains(value);
+  output.index.try_emplace(name, number);
+  if (is_alias)
+    output.state.aliases.emplace_back(std::move(name), std::move(value), number);
+  else
+    output.state.values.emplace_back(std::move(name), std::move(value), number);
+}
+bool vkma_xml::detail::api_t::append_flag_bit(transparent_map<enum_t> &output,
+                                              transparent_set const &typedefs,
+                                              std::string_view type, identifier_t &&name,
+                                              value_t &&value) {
+  if (!is_flag_bits(type) || !typedefs.contains(type))
+    return false;
+  auto [iterator, is_new] = output.try_emplace(identifier_t(type));
+  if (is_new)
+    iterator->second.name = type;
+  append_enumerator(iterator->second, std::move(name), std::move(value));
+  return true;
+}
+void vkma_xml::detail::api_t::apply_flag_bits(transparent_map<enum_t> const &flag_bits,
+                                              identifier_t const &name, type_t &type_data) {
+  if (auto bits = flag_bits.find(name); bits != flag_bits.end())
+    if (auto *alias = std::get_if<type::alias>(&type_data.state); alias) {
+      auto enumeration = bits->second.state;
+      enumeration.type = alias->real_type;
+      type_data.state = std::move(enumeration);
+    }
+}
+// Where 'stem' is in 'name', if nothing but a revision number and a vendor suffix follows it.
+static size_t find_bitmask_stem(std::string_view name, std::string_view stem) {
+  auto position = name.rfind(stem);
+  if (position == std::string_view::npos)
+    return position;
+  auto suffix = name.substr(position + stem.size());
+  auto vendor = std::find_if_not(suffix.begin(), suffix.end(), [](char character) {
+    return std::isdigit(static_cast<unsigned char>(character));
+  });
+  if (std::all_of(vendor, suffix.end(), [](char character) {
+        return std::isupper(static_cast<unsigned char>(character));
+      }))
+    return position;
+  return std::string_view::npos;
+}
+std::optional<vkma_xml::detail::identifier_t>
+vkma_xml::detail::flag_bits_of(std::string_view name) {
+  if (auto position = find_bitmask_stem(name, "Flags"); position != std::string_view::npos)
+    return identifier_t(name.substr(0, position)) += "FlagBits"
+                                                     + std::string(name.substr(position + 5));
+  return std::nullopt;
+}
+bool vkma_xml::detail::is_flag_bits(std::string_view name) {
+  return find_bitmask_stem(name, "FlagBits") != std::string_view::npos;
+}
 std::optional<vkma_xml::detail::variable_t>
 vkma_xml::detail::api_t::load_typedef(pugi::xml_node const &xml) {
+  trace_span_t span("load_typedef");
   if (auto name = xml.child("name"), type = xml.child("type"), args = xml.child("argsstring");
       name && type && args)
     return std::make_optional<variable_t>(to_string(name), to_string(type) + to_string(args));
@@ -207,17 +539,60 @@ vkma_xml::detail::api_t::load_function_parameter(pugi::xml_node const &xml) {
     return std::make_optional<variable_t>(to_string(name), to_string(type));
   return std::nullopt;
 }
+std::vector<vkma_xml::detail::variable_t>
+vkma_xml::detail::api_t::load_function_parameters(pugi::xml_node const &xml) {
+  std::vector<variable_t> output;
+  output.reserve(count_children(xml, "param"));
+  for (auto &child : xml.children())
+    if (child.name() == "param"sv)
+      if (auto parameter = load_function_parameter(child); parameter)
+        output.emplace_back(std::move(*parameter));
+  return output;
+}
+// The text of the element 'xml' within 'source', the text it was parsed from, so that it can be
+// parsed again on its own. 'std::nullopt' if it cannot be told apart there.
+static std::optional<vkma_xml::detail::source_slice_t>
+slice_of(pugi::xml_node const &xml, vkma_xml::detail::api_t::source_t const &source) {
+  std::string_view text = *source;
+  std::string_view name = xml.name();
+  auto offset = xml.offset_debug(); // Of the name, right after the '<'.
+  if (offset < 1 || static_cast<size_t>(offset) + name.size() > text.size()
+      || text[offset - 1] != '<' || text.substr(offset, name.size()) != name)
+    return std::nullopt;
+  size_t begin = offset - 1, end = text.find('>', offset);
+  if (end == std::string_view::npos)
+    return std::nullopt;
+  if (text[end - 1] != '/') { // Not an empty element.
+    auto closing = "</" + std::string(name) + '>';
+    if (end = text.find(closing, end); end == std::string_view::npos)
+      return std::nullopt;
+    end += closing.size() - 1;
+  }
+  return vkma_xml::detail::source_slice_t{ source, begin, end + 1 - begin };
+}
+template <typename decoder_t>
+static auto decode_slice(vkma_xml::detail::source_slice_t const &slice, decoder_t const &decoder) {
+  pugi::xml_document fragment;
+  auto view = slice.view();
+  fragment.load_buffer(view.data(), view.size());
+  return decoder(fragment.first_child());
+}
 std::optional<vkma_xml::detail::function_t>
-vkma_xml::detail::api_t::load_function(pugi::xml_node const &xml) {
+vkma_xml::detail::api_t::load_function(pugi::xml_node const &xml, source_t const &owner) {
+  trace_span_t span("load_function");
   function_t output;
   for (auto &child : xml.children())
-    if (child.name() == "type"sv)
-      output.state.return_type = to_string(child);
-    else if (child.name() == "name"sv)
-      output.name = to_string(child);
-    else if (child.name() == "param"sv)
-      if (auto parameter = load_function_parameter(child); parameter)
-        output.state.parameters.emplace_back(*parameter);
+    switch (elements.find(child.name())) {
+    case element_t::type: output.state.return_type = to_string(child); break;
+    case element_t::name: output.name = to_string(child); break;
+    default: break;
+    }
+  if (auto slice = owner ? slice_of(xml, owner) : std::nullopt; slice)
+    output.state.parameters = bind_current_run([slice = std::move(*slice)] {
+      return decode_slice(slice, load_function_parameters);
+    });
+  else
+    output.state.parameters = load_function_parameters(xml);
   if (output.name != "" && output.state.return_type)
     return output;
   else
@@ -259,171 +634,523 @@ vkma_xml::detail::api_t::load_function_pointer(std::string_view type_name) {
   return output;
 }
 
-void vkma_xml::detail::api_t::load_struct(pugi::xml_node const &xml, type_tag tag) {
-  std::string_view name;
-  type::structure structure;
+std::optional<vkma_xml::detail::type_t>
+vkma_xml::detail::api_t::make_typedef(variable_t const &type_def, type_tag tag) {
+  if (type_def.name != type_def.type.name())
+    if (std::string_view(type_def.name).substr(0, 3) == "PFN")
+      if (auto pointer = load_function_pointer(type_def.type.name()); pointer)
+        return type_t{ std::move(*pointer), tag };
+      else
+        detail::message() << "Warning: Ignore a function pointer: '" << type_def.name
+                          << "'. Parsing has failed.\n";
+    else
+      return type_t{ type::alias{ type_def.type }, tag };
+  return std::nullopt;
+}
+
+std::vector<vkma_xml::detail::variable_t>
+vkma_xml::detail::api_t::load_struct_members(pugi::xml_node const &xml) {
+  size_t member_count = 0;
   for (auto &child : xml.children())
-    if (child.name() == "compoundname"sv)
-      name = child.child_value();
-    else if (child.name() == "sectiondef"sv)
+    if (child.name() == "sectiondef"sv)
+      member_count += count_children(child, "memberdef");
+
+  std::vector<variable_t> output;
+  output.reserve(member_count);
+  for (auto &child : xml.children())
+    if (child.name() == "sectiondef"sv)
       for (auto &member : child.children())
         if (member.name() == "memberdef"sv)
-          if (auto kind = member.attribute("kind").value(); kind == "variable"sv) {
+          if (auto kind = member.attribute("kind").value();
+              member_kinds.find(kind) == member_kind_t::variable) {
             if (auto variable = load_variable(member); variable)
-              structure.members.emplace_back(*variable);
+              output.emplace_back(std::move(*variable));
           } else
-            std::cout << "Warning: Ignore a struct member: '" << kind
-                      << "'. Only variables are supported.\n";
+            detail::message() << "Warning: Ignore a struct member: '" << kind
+                              << "'. Only variables are supported.\n";
         else
-          std::cout << "Warning: Ignore an unknown struct member: '" << member.name() << "'.\n";
+          detail::message() << "Warning: Ignore an unknown struct member: '" << member.name()
+                            << "'.\n";
+  return output;
+}
+void vkma_xml::detail::api_t::load_struct(pugi::xml_node const &xml, type_tag tag,
+                                          source_t const &owner) {
+  trace_span_t span("load_struct");
+  std::string_view name = xml.child("compoundname").child_value();
+  type::structure structure;
+  structure.is_union = xml.attribute("kind").value() == "union"sv;
+  if (auto slice = owner ? slice_of(xml, owner) : std::nullopt; slice)
+    structure.members = bind_current_run([slice = std::move(*slice)] {
+      return decode_slice(slice, load_struct_members);
+    });
+  else
+    structure.members = load_struct_members(xml);
 
   if (name != "")
-    registry.add(name, type_t{ std::move(structure), tag });
+    add(identifier_t(name), type_t{ std::move(structure), tag });
   else
-    std::cout << "Warning: Ignore a struct compound without a name.\n";
+    detail::message() << "Warning: Ignore a struct compound without a name.\n";
 }
 
-void vkma_xml::detail::api_t::load_file(pugi::xml_node const &xml, type_tag tag) {
+std::optional<std::pair<vkma_xml::detail::identifier_t, vkma_xml::detail::type_t>>
+vkma_xml::detail::api_t::load_file_member(pugi::xml_node const &member, type_tag tag,
+                                          source_t const &owner) {
+  switch (auto kind = member.attribute("kind").value(); member_kinds.find(kind)) {
+  case member_kind_t::define:
+    if (auto define = load_define(member); define)
+      return std::make_pair(std::move(define->name),
+                            type_t{ type::macro{ std::move(define->value) }, tag });
+    break;
+  case member_kind_t::enumeration:
+    if (auto enumeration = load_enum(member); enumeration)
+      return std::make_pair(std::move(enumeration->name),
+                            type_t{ type::enumeration{ std::move(enumeration->state) }, tag });
+    break;
+  case member_kind_t::type_def:
+    if (auto type_def = load_typedef(member); type_def)
+      if (auto type_data = make_typedef(*type_def, tag); type_data)
+        return std::make_pair(std::move(type_def->name), std::move(*type_data));
+    break;
+  case member_kind_t::function:
+    if (auto function = load_function(member, owner); function)
+      return std::make_pair(std::move(function->name),
+                            type_t{ type::function{ std::move(function->state) }, tag });
+    break;
+  default: detail::message() << "Ignore an unknown file entry '" << kind << "'.\n";
+  }
+  return std::nullopt;
+}
+void vkma_xml::detail::api_t::load_file(pugi::xml_node const &xml, type_tag tag,
+                                        source_t const &owner) {
+  trace_span_t span("load_file");
+  std::vector<pugi::xml_node> members;
   for (auto &child : xml.children())
     if (child.name() == "sectiondef"sv)
       for (auto &member : child.children())
-        if (member.name() == "memberdef"sv) {
-          if (auto kind = member.attribute("kind").value(); kind == "define"sv) {
-            if (auto define = load_define(member); define)
-              registry.add(std::move(define->name),
-                           type_t{ type::macro{ std::move(define->value) }, tag });
-          } else if (kind == "enum"sv) {
-            if (auto enumeration = load_enum(member); enumeration)
-              registry.add(std::move(enumeration->name),
-                           type_t{ type::enumeration{ std::move(enumeration->state) }, tag });
-          } else if (kind == "typedef"sv) {
-            if (auto type_def = load_typedef(member); type_def)
-              if (type_def->name != type_def->type.name)
-                if (std::string_view(type_def->name).substr(0, 3) == "PFN")
-                  if (auto pointer = load_function_pointer(type_def->type.name); pointer)
-                    registry.add(std::move(type_def->name), type_t{ *pointer, tag });
-                  else
-                    std::cout << "Warning: Ignore a function pointer: '" << type_def->name
-                              << "'. Parsing has failed.\n";
-                else
-                  registry.add(std::move(type_def->name),
-                               type_t{ type::alias{ std::move(type_def->type) }, tag });
-          } else if (kind == "function"sv) {
-            if (auto function = load_function(member); function)
-              registry.add(std::move(function->name),
-                           type_t{ type::function{ std::move(function->state) }, tag });
-          } else
-            std::cout << "Ignore an unknown file entry '" << kind << "'.\n";
-        }
+        if (member.name() == "memberdef"sv)
+          members.emplace_back(member);
+  if (span)
+    span.arg("members", members.size());
+
+  // The values of 64-bit flag bits follow the typedef they turn into an enumeration.
+  transparent_set typedefs;
+  transparent_map<enum_t> flag_bits;
+  std::erase_if(members, [&typedefs, &flag_bits](pugi::xml_node const &member) {
+    switch (member_kinds.find(member.attribute("kind").value())) {
+    case member_kind_t::type_def: typedefs.emplace(member.child("name").child_value()); break;
+    case member_kind_t::variable:
+      if (auto type = to_string(member.child("type")); type.starts_with("const "))
+        return append_flag_bit(flag_bits, typedefs, std::string_view(type).substr(6),
+                               to_string(member.child("name")),
+                               to_string(member.child("initializer")));
+      break;
+    default: break;
+    }
+    return false;
+  });
+
+  size_t chunk_count = std::min<size_t>(members.size() / file_chunk_size,
+                                        std::max(std::thread::hardware_concurrency(), 1u));
+  if (chunk_count < 2) {
+    for (auto const &member : members)
+      if (auto entry = load_file_member(member, tag, owner); entry) {
+        apply_flag_bits(flag_bits, entry->first, entry->second);
+        add(std::move(entry->first), std::move(entry->second));
+      }
+    return;
+  }
+
+  // Chunks are parsed concurrently, the registry sees the members in the document order and
+  // their warnings come out in that order as well.
+  sharded_registry_t output;
+  std::vector<message_buffer_t> messages(chunk_count);
+  task_graph_t graph;
+  for (size_t chunk = 0; chunk < chunk_count; ++chunk)
+    graph.add("load_file_chunk",
+              [&members, &flag_bits, &output, &messages, &owner, tag, chunk, chunk_count] {
+                message_buffer_t::capture_t capture(messages[chunk]);
+                size_t begin = members.size() * chunk / chunk_count;
+                size_t end = members.size() * (chunk + 1) / chunk_count;
+                for (size_t i = begin; i < end; ++i)
+                  if (auto entry = load_file_member(members[i], tag, owner); entry) {
+                    apply_flag_bits(flag_bits, entry->first, entry->second);
+                    output.add({ 0, i }, std::move(entry->first), std::move(entry->second));
+                  }
+              });
+  graph.run(chunk_count);
+  for (auto &buffer : messages)
+    buffer.flush();
+  output.merge(*this);
 }
 
+bool vkma_xml::detail::api_t::load_compound(source_t const &source,
+                                            std::filesystem::path const &file, type_tag tag) {
+  auto xml = detail::load_xml(*source, file);
+  if (!xml)
+    return false;
+  // Core entities are always emitted, so only helper ones are worth leaving undecoded. They only
+  // keep the parts of 'source' they are decoded from alive, not the document.
+  auto owner = tag == type_tag::helper ? source : nullptr;
+  if (auto doxygen = xml->child("doxygen"); doxygen)
+    if (auto compound = doxygen.child("compounddef"); compound)
+      switch (auto kind = compound.attribute("kind").value(); compound_kinds.find(kind)) {
+      case compound_kind_t::structure:
+      case compound_kind_t::union_type: load_struct(compound, tag, owner); break;
+      case compound_kind_t::file: load_file(compound, tag, owner); break;
+      default:
+        detail::message() << "Warning: Ignore a compound of an unknown kind: '" << kind << "'.\n";
+      }
+  return true;
+}
 void vkma_xml::detail::api_t::load_compound(std::string_view refid,
                                             std::filesystem::path const &directory, type_tag tag) {
   std::filesystem::path file_path = directory;
   (file_path /= refid.data()) += ".xml";
-  if (auto compound_xml = detail::load_xml(file_path); compound_xml)
-    if (auto doxygen = compound_xml->child("doxygen"); doxygen)
-      if (auto compound = doxygen.child("compounddef"); compound)
-        if (std::string_view kind = compound.attribute("kind").value(); kind == "struct"sv)
-          return load_struct(compound, tag);
-        else if (kind == "file"sv)
-          return load_file(compound, tag);
-        else
-          std::cout << "Warning: Ignore a compound of an unknown kind: '" << kind << "'.\n";
-}
-
-void vkma_xml::detail::api_t::load_helper(input const &helper_api) {
-  if (auto api_index = detail::load_xml(helper_api.xml_directory.string() + "/index.xml");
-      api_index)
-    if (auto index = api_index->child("doxygenindex"); index)
-      for (auto const &compound : index.children())
-        if (compound.name() == "compound"sv)
-          if (auto kind = compound.attribute("kind").value();
-              kind == "struct"sv || kind == "file"sv)
-            load_compound(compound.attribute("refid").value(), helper_api.xml_directory,
-                          type_tag::helper);
-          else if (kind == "page"sv || kind == "dir"sv) {
-            // Silently ignore 'page' and 'dir' index entries.
-          } else
-            std::cout << "Warning: Ignore a compound of an unknown kind: '" << kind << "'.\n";
-        else
-          std::cout << "Warning: Ignore an unknown node: " << compound.name() << '\n';
+  trace_span_t span("load_compound");
+  if (std::error_code error; span)
+    span.arg("refid", refid).arg("bytes", std::filesystem::file_size(file_path, error));
+  if (auto source = detail::load_text(file_path); source)
+    load_compound(std::make_shared<std::string const>(std::move(*source)), file_path, tag);
+}
+std::vector<std::string_view>
+vkma_xml::detail::api_t::load_index_refids(pugi::xml_node const &index) {
+  std::vector<std::string_view> output;
+  for (auto const &compound : index.children())
+    if (compound.name() == "compound"sv)
+      switch (auto kind = compound.attribute("kind").value(); compound_kinds.find(kind)) {
+      case compound_kind_t::structure:
+      case compound_kind_t::union_type:
+      case compound_kind_t::file: output.emplace_back(compound.attribute("refid").value()); break;
+      case compound_kind_t::page:
+      case compound_kind_t::dir: break; // Silently ignore 'page' and 'dir' index entries.
+      default:
+        detail::message() << "Warning: Ignore a compound of an unknown kind: '" << kind << "'.\n";
+      }
+    else
+      detail::message() << "Warning: Ignore an unknown node: " << compound.name() << '\n';
+  return output;
+}
+void vkma_xml::detail::api_t::load_index(pugi::xml_node const &index,
+                                         std::filesystem::path const &directory, type_tag tag) {
+  auto refids = load_index_refids(index);
+  if (shard)
+    shard->select(refids);
+  std::vector<std::filesystem::path> files;
+  for (auto const &refid : refids)
+    (files.emplace_back(directory) /= refid) += ".xml";
+
+  // Parsing of a compound overlaps with reading of the ones after it.
+  read_ahead_t reader(files);
+  for (size_t i = 0; i < files.size() && !is_stop_requested(); ++i)
+    if (auto source = reader.next(); source) {
+      trace_span_t span("load_compound");
+      if (span)
+        span.arg("refid", refids[i]).arg("bytes", source->size());
+      load_compound(std::make_shared<std::string const>(std::move(*source)), files[i], tag);
+    } else if (!is_stop_requested())
+      detail::message() << "Error: Ignore '" << std::filesystem::absolute(files[i])
+                        << "'. Unable to read it. Make sure it exists and is accessible.\n";
+}
+bool vkma_xml::detail::api_t::load_index(archive_t &archive, type_tag tag) {
+  // The index is only known once the archive gets to it: until then, every compound is kept.
+  struct compound_t {
+    std::optional<registry_journal_t> journal; // 'std::nullopt' if it is not a valid document.
+    message_buffer_t messages;
+  };
+  transparent_map<compound_t> compounds;
+  std::string index_name;
+  std::vector<std::string> refids;
+  std::optional<transparent_map<size_t>> positions; // Of the compounds the index lists.
+  bool is_index_valid = false;
+  auto use_index = [&](archive_t::member_t const &member) {
+    index_name = member.name;
+    refids.clear();
+    positions.emplace();
+    is_index_valid = false;
+    auto api_index = detail::load_xml(member.content, archive.path() / member.name);
+    if (!api_index)
+      return;
+    auto index = api_index->child("doxygenindex");
+    if (!index)
+      return;
+    is_index_valid = true;
+    auto listed = load_index_refids(index);
+    if (shard)
+      shard->select(listed);
+    // The tree may be archived with any leading directories ('xml/', 'docs/xml/', ...).
+    auto root = member.name.substr(0, member.name.size() - 9);
+    for (auto refid : listed) {
+      positions->try_emplace(root + std::string(refid) + ".xml", refids.size());
+      refids.emplace_back(refid);
+    }
+    std::erase_if(compounds, [&](auto const &compound) {
+      return !positions->contains(compound.first);
+    });
+  };
 
-  for (auto const &handle : detail::load_handle_list(helper_api.header_files))
-    registry.add(handle.first,
-                 detail::type_t{ detail::type::handle{ handle.second }, detail::type_tag::helper });
+  // Each compound is recorded on its own, so that it reaches the registry in the index order
+  // whatever order the archive has.
+  auto outer_journal = std::exchange(journal, std::nullopt);
+  while (!is_stop_requested()) {
+    auto member = archive.next();
+    if (!member)
+      break;
+    std::string_view name = member->name;
+    if (name == "index.xml"sv || name.ends_with("/index.xml"sv)) {
+      if (index_name.empty() || name.size() < index_name.size())
+        use_index(*member);
+      continue;
+    }
+    if (!name.ends_with(".xml"sv) || (positions && !positions->contains(name))
+        || compounds.contains(name))
+      continue;
+
+    auto &compound = compounds[member->name];
+    message_buffer_t::capture_t capture(compound.messages);
+    trace_span_t span("load_compound");
+    if (span)
+      span.arg("file", name).arg("bytes", member->content.size());
+    journal.emplace();
+    auto file = archive.path() / member->name;
+    if (load_compound(std::make_shared<std::string const>(std::move(member->content)), file, tag))
+      compound.journal = std::move(journal);
+    journal.reset();
+  }
+  journal = std::move(outer_journal);
+
+  if (index_name.empty()) {
+    detail::message() << "Error: " << std::filesystem::absolute(archive.path())
+                      << " contains no 'index.xml'.\n";
+    return false;
+  } else if (!is_index_valid)
+    return false;
+  std::vector<compound_t *> ordered(refids.size());
+  for (auto const &[name, position] : *positions)
+    if (auto compound = compounds.find(name); compound != compounds.end())
+      ordered[position] = &compound->second;
+  for (size_t i = 0; i < refids.size() && !is_stop_requested(); ++i)
+    if (!ordered[i])
+      detail::message() << "Error: Ignore '" << refids[i] << ".xml'. " << archive.path()
+                        << " does not contain it.\n";
+    else {
+      ordered[i]->messages.flush();
+      if (ordered[i]->journal)
+        ordered[i]->journal->replay(*this);
+    }
+  return true;
+}
+bool vkma_xml::detail::api_t::load_doxygen(std::filesystem::path const &xml_directory,
+                                           type_tag tag) {
+  if (std::filesystem::is_regular_file(xml_directory)) {
+    if (auto archive = archive_t::open(xml_directory); archive)
+      return load_index(*archive, tag);
+  } else if (auto api_index = detail::load_xml(xml_directory.string() + "/index.xml"); api_index)
+    if (auto index = api_index->child("doxygenindex"); index) {
+      load_index(index, xml_directory, tag);
+      return true;
+    }
+  return false;
 }
 
-std::optional<vkma_xml::detail::api_t>
-vkma_xml::parse(input main_api, std::initializer_list<input> const &helper_apis) {
-  std::cout << "Parse API located at " << main_api.xml_directory << ""
-            << (main_api.header_files.size() ? " with headers:" : "") << "\n";
-  for (auto const &header : main_api.header_files)
-    std::cout << "    " << header << "\n";
-  if (helper_apis.size()) {
-    std::cout << "\nHelpers:\n";
-    for (auto const &helper : helper_apis) {
-      std::cout << "API located at " << helper.xml_directory << ""
-                << (helper.header_files.size() ? " with headers:" : "") << "\n";
-      for (auto const &header : helper.header_files)
-        std::cout << "    " << header << "\n";
+bool vkma_xml::detail::api_t::load_input(input const &api, type_tag tag) {
+  bool is_loaded = load_doxygen(api.xml_directory, tag);
+
+  if (!shard || shard->is_last())
+    for (auto const &handle : detail::load_handle_list(api.header_files))
+      add(identifier_t(handle.first),
+          detail::type_t{ detail::type::handle{ handle.second }, tag });
+  return is_loaded;
+}
+
+void vkma_xml::detail::api_t::add(identifier_t &&name, type_t &&type_data) {
+  if (journal)
+    journal->add(std::move(name), std::move(type_data));
+  else
+    registry.add(std::move(name), std::move(type_data));
+}
+void vkma_xml::detail::api_t::get(identifier_t &&name) {
+  if (journal)
+    journal->get(std::move(name));
+  else
+    registry.get(std::move(name));
+}
+
+static void print_inputs(std::vector<vkma_xml::input const *> const &inputs) {
+  auto message = vkma_xml::detail::message();
+  message << "Parse API located at " << inputs.front()->xml_directory << ""
+          << (inputs.front()->header_files.size() ? " with headers:" : "") << "\n";
+  for (auto const &header : inputs.front()->header_files)
+    message << "    " << header << "\n";
+  if (inputs.size() > 1) {
+    message << "\nHelpers:\n";
+    for (auto const *helper : std::vector(inputs.begin() + 1, inputs.end())) {
+      message << "API located at " << helper->xml_directory << ""
+              << (helper->header_files.size() ? " with headers:" : "") << "\n";
+      for (auto const &header : helper->header_files)
+        message << "    " << header << "\n";
     }
   }
-  std::cout << std::endl;
+  message << "\n";
+}
+void vkma_xml::detail::finish_parsing(api_t &api,
+                                      std::chrono::high_resolution_clock::time_point start_time) {
+  for (auto const &base_type : base_types)
+    api.registry.add(base_type, type_t{ type::base{}, type_tag::helper });
+
+  transparent_set undefined;
+  for (auto const &type : api.registry)
+    if (std::holds_alternative<type::undefined>(type.second.state))
+      undefined.insert(type.first);
+
+  auto message = detail::message();
+  message << "Generator: finish parsing XMLs (It took "
+          << std::chrono::duration_cast<std::chrono::duration<float>>(
+               std::chrono::high_resolution_clock::now() - start_time)
+               .count()
+          << "s)\n";
+  if (!undefined.empty()) {
+    message << "Warning: Undefined types left after parsing is over:\n";
+    for (auto const &name : undefined)
+      message << "- " << name << "\n";
+  }
+  message << "\n";
+}
+
+// 64-bit FNV-1a of everything the shards of a set have to agree on, see 'api_t::input_fingerprint'.
+// Every field is terminated, and a missing file counts as empty: its loader reports it already.
+static std::uint64_t fingerprint_inputs(std::vector<vkma_xml::input const *> const &inputs,
+                                        bool use_headers) {
+  std::uint64_t output = 14695981039346656037ull;
+  auto add = [&output](std::string_view data) {
+    for (auto character : data)
+      (output ^= static_cast<unsigned char>(character)) *= 1099511628211ull;
+    (output ^= 0xff) *= 1099511628211ull;
+  };
+  auto add_file = [&add](std::filesystem::path const &file) {
+    std::optional<std::string> content;
+    if (std::filesystem::is_regular_file(file))
+      content = vkma_xml::detail::load_text(file);
+    add(content.value_or(""));
+  };
+  add(use_headers ? "headers"sv : "doxygen"sv);
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    add(i == 0 || inputs[i]->is_core ? "core"sv : "helper"sv);
+    if (!use_headers)
+      add_file(std::filesystem::is_regular_file(inputs[i]->xml_directory)
+                 ? inputs[i]->xml_directory
+                 : inputs[i]->xml_directory / "index.xml");
+    add(std::to_string(inputs[i]->header_files.size()));
+    for (auto const &header : inputs[i]->header_files)
+      add_file(header);
+  }
+  return output;
+}
+
+// Every input is loaded on its own, into a journal, while the registry takes them one by one in
+// the input order. 'std::nullopt' if the main one could not be loaded or the call was stopped.
+// A shard keeps the journals instead.
+template <typename load_t>
+static std::optional<vkma_xml::detail::api_t>
+load_inputs(std::vector<vkma_xml::input const *> const &inputs, load_t const &load,
+            std::optional<vkma_xml::detail::shard_t> shard) {
+  namespace detail = vkma_xml::detail;
+  std::vector<detail::api_t> staged(inputs.size());
+  // The messages of an input come out once the ones before it are merged, as if loaded in turn.
+  std::vector<detail::message_buffer_t> messages(inputs.size());
+  std::atomic<bool> is_main_loaded = false;
+  detail::api_t output;
+
+  detail::task_graph_t graph;
+  std::optional<detail::task_graph_t::task_id> previous;
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    auto tag = i == 0 || inputs[i]->is_core ? detail::type_tag::core : detail::type_tag::helper;
+    staged[i].journal.emplace();
+    staged[i].shard = shard;
+    auto loaded =
+      graph.add("load_input", [&inputs, &staged, &messages, &load, &is_main_loaded, i, tag] {
+        detail::message_buffer_t::capture_t capture(messages[i]);
+        if (load(staged[i], *inputs[i], tag) && i == 0)
+          is_main_loaded = true;
+      });
+
+    if (shard)
+      continue;
+    std::vector<detail::task_graph_t::task_id> dependencies = { loaded };
+    if (previous)
+      dependencies.emplace_back(*previous);
+    previous = graph.add(
+      "merge_input",
+      [&staged, &messages, &output, i] {
+        messages[i].flush();
+        staged[i].journal->replay(output.registry);
+      },
+      dependencies);
+  }
+  bool is_finished = graph.run();
+  for (auto &buffer : messages) // What is left if unmerged: for a shard or once stopped.
+    buffer.flush();
+  if (!is_finished || !is_main_loaded)
+    return std::nullopt;
+  output.shard = shard;
+  if (shard)
+    for (auto &input : staged)
+      output.partial_journals.emplace_back(std::move(*input.journal));
+  return output;
+}
+
+std::optional<vkma_xml::detail::api_t>
+vkma_xml::detail::parse(std::vector<input const *> const &inputs, std::optional<shard_t> shard) {
+  trace_span_t span("parse");
+  print_inputs(inputs);
 
   auto start_time = std::chrono::high_resolution_clock::now();
-  if (auto main_api_index = detail::load_xml(main_api.xml_directory.string() + "/index.xml");
-      main_api_index)
-    if (auto index = main_api_index->child("doxygenindex"); index) {
-      detail::api_t api;
-      for (auto const &compound : index.children())
-        if (compound.name() == "compound"sv)
-          if (auto kind = compound.attribute("kind").value();
-              kind == "struct"sv || kind == "file"sv)
-            api.load_compound(compound.attribute("refid").value(), main_api.xml_directory,
-                              detail::type_tag::core);
-          else if (kind == "page"sv || kind == "dir"sv) {
-            // Silently ignore 'page' and 'dir' index entries.
-          } else
-            std::cout << "Warning: Ignore a compound of an unknown kind: '" << kind << "'.\n";
-        else
-          std::cout << "Warning: Ignore an unknown node: " << compound.name() << '\n';
-
-      for (auto const &handle : detail::load_handle_list(main_api.header_files))
-        api.registry.add(handle.first, detail::type_t{ detail::type::handle{ handle.second },
-                                                       detail::type_tag::core });
-
-      for (auto const &helper_api : helper_apis)
-        api.load_helper(helper_api);
-
-      for (auto const &base_type : detail::base_types)
-        api.registry.add(base_type,
-                         detail::type_t{ detail::type::base{}, detail::type_tag::helper });
-
-      detail::transparent_set undefined;
-      for (auto const &type : api.registry)
-        if (std::holds_alternative<detail::type::undefined>(type.second.state))
-          undefined.insert(type.first);
-
-      std::cout << "Generator: finish parsing XMLs (It took "
-                << std::chrono::duration_cast<std::chrono::duration<float>>(
-                     std::chrono::high_resolution_clock::now() - start_time)
-                     .count()
-                << "s)\n";
-      if (!undefined.empty()) {
-        std::cout << "Warning: Undefined types left after parsing is over:\n";
-        for (auto const &name : undefined)
-          std::cout << "- " << name << "\n";
-      }
-      std::cout << std::endl;
+  auto api = load_inputs(
+    inputs,
+    [](api_t &output, input const &api, type_tag tag) { return output.load_input(api, tag); },
+    shard);
+  if (api && shard)
+    api->input_fingerprint = fingerprint_inputs(inputs, false);
+  else if (api)
+    finish_parsing(*api, start_time);
+  return api;
+}
+std::optional<vkma_xml::detail::api_t>
+vkma_xml::detail::parse_headers(std::vector<input const *> const &inputs,
+                                std::optional<shard_t> shard) {
+  trace_span_t span("parse_headers");
+  print_inputs(inputs);
 
-      return api;
-    }
-  return std::nullopt;
+  auto start_time = std::chrono::high_resolution_clock::now();
+  auto api = load_inputs(
+    inputs,
+    [](api_t &output, input const &api, type_tag tag) {
+      output.load_headers(api.header_files, tag);
+      return true;
+    },
+    shard);
+  if (api && shard)
+    api->input_fingerprint = fingerprint_inputs(inputs, true);
+  else if (api)
+    finish_parsing(*api, start_time);
+  return api;
+}
+std::optional<vkma_xml::detail::api_t>
+vkma_xml::parse(input main_api, std::initializer_list<input> const &helper_apis) {
+  std::vector<input const *> inputs = { &main_api };
+  for (auto const &helper_api : helper_apis)
+    inputs.emplace_back(&helper_api);
+  return detail::parse(inputs);
+}
+std::optional<vkma_xml::detail::api_t>
+vkma_xml::parse_headers(input main_api, std::initializer_list<input> const &helper_apis) {
+  std::vector<input const *> inputs = { &main_api };
+  for (auto const &helper_api : helper_apis)
+    inputs.emplace_back(&helper_api);
+  return detail::parse_headers(inputs);
 }
 
 static std::string to_upper_case(std::string_view input) {
-  static std::locale locale("en_US.UTF8");
+  auto const &locale = std::locale::classic();
 
   std::string output(input.substr(0, 1));
   output.reserve(input.size());
@@ -437,322 +1164,253 @@ static std::string to_upper_case(std::string_view input) {
 }
 
 static std::string to_objtypeenum(std::string_view input) {
+  // 'VkBuffer' is 'VK_OBJECT_TYPE_BUFFER', as in 'vk.xml'. Other apis keep their own prefix.
   std::string output = to_upper_case(input);
-  if (std::string_view(output).substr(0, 4) == "VKMA_")
-    return output.insert(0, "VK_OBJECT_TYPE_");
+  if (std::string_view(output).starts_with("VK_"))
+    return output.insert(3, "OBJECT_TYPE_");
   return output;
 }
 
-vkma_xml::detail::generator_t::generator_t(api_t const &api)
-  : api(api), output(std::make_optional<pugi::xml_document>()),
-    registry(output->append_child("registry")) {}
-
-void vkma_xml::detail::generator_t::append_typename(pugi::xml_node &xml,
-                                                    decorated_typename_t const &type) {
-  xml.append_child(pugi::node_pcdata).set_value(type.prefix.data());
-  xml.append_child("type").append_child(pugi::node_pcdata).set_value(type.name.data());
-  xml.append_child(pugi::node_pcdata).set_value(type.postfix.data());
-}
-
-void vkma_xml::detail::generator_t::append_header() {
-  if (registry) {
-    registry->append_child("comment")
-      .append_child(pugi::node_pcdata)
-      .set_value("\nCopyright (c) 2021 Cvelth (cvelth.mail@gmail.com)"
-                 "\nSPDX-License-Identifier: Unlicense.");
-    registry->append_child("comment")
-      .append_child(pugi::node_pcdata)
-      .set_value(
-        "\nDO NOT MODIFY MANUALLY!"
-        "\nThis file was generated using [generator](https://github.com/Cvelth/vkma_xml_generator)."
-        "\nGenerated files are licensed under [The Unlicense](https://unlicense.org)."
-        "\nThe generator itself is licensed under [MIT "
-        "License](https://www.mit.edu/~amini/LICENSE.md).");
-    registry->append_child("comment")
-      .append_child(pugi::node_pcdata)
-      .set_value(
-        "\nThis file was generated from xml 'doxygen' documentation for "
-        "[vkma_bindings.hpp](https://github.com/Cvelth/vkma_bindings/blob/main/include/"
-        "vkma_bindings.hpp) "
-        "header."
-        "\nHeaders used for name lookup: "
-        "\n[vk_mem_alloc.h "
-        "(VulkanMemoryAllocator)](https://github.com/GPUOpen-LibrariesAndSDKs/"
-        "VulkanMemoryAllocator/blob/master/include/vk_mem_alloc.h) "
-        "\n[vulkan_core.h "
-        "(Vulkan-Headers)](https://github.com/KhronosGroup/Vulkan-Headers/blob/master/include/"
-        "vulkan/vulkan_core.h) "
-        "\n\nIt is intended to be used as [vulkan-hpp "
-        "fork](https://github.com/Cvelth/vkma_vulkan_hpp_fork) generator input."
-        "\nThe goal is to generate a "
-        "[vulkan-hpp](https://github.com/KhronosGroup/Vulkan-Hpp/blob/master/vulkan/vulkan.hpp) "
-        "compatible header - a better c++ interface for VulkanMemoryAllocator.");
-
-    auto platforms = registry->append_child("platforms");
-    platforms.append_attribute("comment").set_value("empty");
-    auto platform = platforms.append_child("platform");
-    platform.append_attribute("name").set_value("does_not_matter");
-    platform.append_attribute("protect").set_value("VKMA_DOES_NOT_MATTER");
-    platform.append_attribute("comment").set_value("Why am I even required to specify this?");
-
-    auto tags = registry->append_child("tags");
-    tags.append_attribute("comment").set_value("empty");
-    auto tag = tags.append_child("tag");
-    tag.append_attribute("name").set_value("WC");
-    tag.append_attribute("author").set_value("Who cares?");
-    tag.append_attribute("contact").set_value("@cvelth");
+vkma_xml::detail::generator_t::generator_t(api_t const &api,
+                                           std::vector<emitter_t *> const &emitters)
+  : api(api), emitters(emitters) {
+  appended_basetypes.reserve(api.registry.size());
+  appended_types.reserve(api.registry.size());
+  appended_commands.reserve(api.registry.size());
+  appended_constants.reserve(api.registry.size());
+}
+
+static bool matches(std::string_view pattern, std::string_view name) {
+  size_t pattern_position = 0, name_position = 0;
+  size_t star = std::string_view::npos, star_match = 0;
+  while (name_position < name.size())
+    if (pattern_position < pattern.size()
+        && (pattern[pattern_position] == '?'
+            || pattern[pattern_position] == name[name_position])) {
+      ++pattern_position;
+      ++name_position;
+    } else if (pattern_position < pattern.size() && pattern[pattern_position] == '*') {
+      star = pattern_position++;
+      star_match = name_position;
+    } else if (star != std::string_view::npos) {
+      pattern_position = star + 1;
+      name_position = ++star_match;
+    } else
+      return false;
+  while (pattern_position < pattern.size() && pattern[pattern_position] == '*')
+    ++pattern_position;
+  return pattern_position == pattern.size();
+}
+
+void vkma_xml::detail::generator_t::select(std::vector<std::string_view> const &roots) {
+  query_t const query(api);
+  query_t::entry_list_t matched;
+  for (auto const &root : roots) {
+    size_t count = 0;
+    if (auto const *entry = query.find(root); entry) {
+      matched.emplace_back(entry);
+      ++count;
+    } else
+      for (auto const *candidate : api.registry.entries())
+        if (candidate->second.tag == type_tag::core && matches(root, candidate->first)) {
+          matched.emplace_back(candidate);
+          ++count;
+        }
+    if (!count)
+      detail::message() << "Warning: No entry matches a root: '" << root << "'.\n";
   }
+
+  selected.assign(api.registry.size(), false);
+  for (auto const *entry : query.closure(matched))
+    selected[entry->second.index] = true;
+  detail::message() << "Generator: " << std::count(selected.begin(), selected.end(), true)
+                    << " out of " << selected.size() << " entries selected.\n";
+}
+
+template <typename... argument_ts, typename... value_ts>
+void vkma_xml::detail::generator_t::emit(void (emitter_t::*method)(argument_ts...),
+                                         value_ts &&...values) {
+  for (auto *emitter : emitters)
+    (emitter->*method)(values...);
 }
 
+void vkma_xml::detail::generator_t::append_header() { emit(&emitter_t::begin); }
+
 void vkma_xml::detail::generator_t::append_types() {
   struct append_types_visitor {
     identifier_t const &name_ref;
     type_tag const &tag;
-    pugi::xml_node &types_ref;
+    size_t index;
     generator_t &generator_ref;
 
     inline void operator()(vkma_xml::detail::type::undefined const &) {
-      std::cout << "Warning: Fail to append an undefined type: '" << name_ref << "'.\n";
+      detail::message() << "Warning: Fail to append an undefined type: '" << name_ref << "'.\n";
     }
     inline void operator()(vkma_xml::detail::type::structure const &structure) {
       if (tag == type_tag::core) {
-        if (!generator_ref.appended_types.contains(name_ref)) {
-          for (auto const &member : structure.members) {
-            if (auto iterator = generator_ref.api.registry.find(member.type.name);
+        if (!generator_ref.appended_types.contains(index)) {
+          for (auto const &member : *structure.members) {
+            if (auto iterator = generator_ref.api.registry.find(member.type.name());
                 iterator != generator_ref.api.registry.end())
-              std::visit(append_types_visitor{ member.type.name, iterator->second.tag, types_ref,
-                                               generator_ref },
+              std::visit(append_types_visitor{ member.type.name(), iterator->second.tag,
+                                               iterator->second.index, generator_ref },
                          iterator->second.state);
             if (member.array)
               if (auto iterator = generator_ref.api.registry.find(*member.array);
                   iterator != generator_ref.api.registry.end())
-                std::visit(append_types_visitor{ *member.array, iterator->second.tag, types_ref,
-                                                 generator_ref },
+                std::visit(append_types_visitor{ *member.array, iterator->second.tag,
+                                                 iterator->second.index, generator_ref },
                            iterator->second.state);
           }
 
-          auto type = types_ref.append_child("type");
-          type.append_attribute("category").set_value("struct");
-          type.append_attribute("name").set_value(name_ref.data());
-          for (auto &member : structure.members) {
-            auto output = type.append_child("member");
-            append_typename(output, member.type);
-            output.append_child(pugi::node_pcdata).set_value(" ");
-            output.append_child("name")
-              .append_child(pugi::node_pcdata)
-              .set_value(member.name.data());
-            if (member.array) {
-              output.append_child(pugi::node_pcdata).set_value("[");
-              output.append_child("enum")
-                .append_child(pugi::node_pcdata)
-                .set_value(member.array->data());
-              output.append_child(pugi::node_pcdata).set_value("]");
-            }
-          }
-          generator_ref.appended_types.emplace(name_ref);
+          generator_ref.emit(&emitter_t::append_struct, name_ref, structure);
+          generator_ref.appended_types.emplace(index, name_ref);
         }
-      } else if (!generator_ref.appended_basetypes.contains(name_ref)) {
-        auto type = types_ref.append_child("type");
-        type.append_attribute("category").set_value("basetype");
-        type.append_child(pugi::node_pcdata).set_value("struct ");
-        type.append_child("name").append_child(pugi::node_pcdata).set_value(name_ref.data());
-        type.append_child(pugi::node_pcdata).set_value(";");
-        generator_ref.appended_basetypes.emplace(name_ref);
+      } else if (!generator_ref.appended_basetypes.contains(index)) {
+        generator_ref.emit(&emitter_t::append_basetype,
+                           structure.is_union ? "union"sv : "struct"sv, name_ref);
+        generator_ref.appended_basetypes.emplace(index, name_ref);
       }
     }
     inline void operator()(vkma_xml::detail::type::handle const &handle) {
       if (tag == type_tag::core) {
-        if (!generator_ref.appended_types.contains(name_ref)) {
+        if (!generator_ref.appended_types.contains(index)) {
           if (handle.parent)
             if (auto iterator = generator_ref.api.registry.find(*handle.parent);
                 iterator != generator_ref.api.registry.end())
-              std::visit(append_types_visitor{ iterator->first, iterator->second.tag, types_ref,
-                                               generator_ref },
+              std::visit(append_types_visitor{ iterator->first, iterator->second.tag,
+                                               iterator->second.index, generator_ref },
                          iterator->second.state);
             else
-              std::cout << "Warning: An undefined aliased type: '" << *handle.parent << "'.\n";
+              detail::message() << "Warning: An undefined aliased type: '" << *handle.parent
+                                << "'.\n";
 
-          auto type = types_ref.append_child("type");
-          type.append_attribute("category").set_value("handle");
-          if (handle.parent)
-            type.append_attribute("parent").set_value(handle.parent->data());
-          type.append_attribute("objtypeenum").set_value(to_objtypeenum(name_ref).data());
-          if (handle.dispatchable)
-            type.append_child("type").append_child(pugi::node_pcdata).set_value("VK_DEFINE_HANDLE");
-          else
-            type.append_child("type")
-              .append_child(pugi::node_pcdata)
-              .set_value("VK_DEFINE_NON_DISPATCHABLE_HANDLE");
-          type.append_child(pugi::node_pcdata).set_value("(");
-          type.append_child("name").append_child(pugi::node_pcdata).set_value(name_ref.data());
-          type.append_child(pugi::node_pcdata).set_value(")");
-          generator_ref.appended_types.emplace(name_ref);
+          generator_ref.emit(&emitter_t::append_handle, name_ref, handle,
+                             std::string_view(to_objtypeenum(name_ref)));
+          generator_ref.appended_types.emplace(index, name_ref);
         }
-      } else if (!generator_ref.appended_basetypes.contains(name_ref)) {
-        auto type = types_ref.append_child("type");
-        type.append_attribute("category").set_value("basetype");
-        type.append_child("name").append_child(pugi::node_pcdata).set_value(name_ref.data());
-        generator_ref.appended_basetypes.emplace(name_ref);
+      } else if (!generator_ref.appended_basetypes.contains(index)) {
+        generator_ref.emit(&emitter_t::append_basetype, ""sv, name_ref);
+        generator_ref.appended_basetypes.emplace(index, name_ref);
       }
     }
     inline void operator()(vkma_xml::detail::type::macro const &macro) {
       if (tag == type_tag::core) {
-        if (!generator_ref.appended_types.contains(name_ref)) {
-          auto type = types_ref.append_child("type");
-          type.append_attribute("category").set_value("define");
-          type.append_child(pugi::node_pcdata).set_value("#define ");
-          type.append_child("name").append_child(pugi::node_pcdata).set_value(name_ref.data());
-          type.append_child(pugi::node_pcdata).set_value((" " + macro.value).data());
-          generator_ref.appended_types.emplace(name_ref);
+        if (!generator_ref.appended_types.contains(index)) {
+          generator_ref.emit(&emitter_t::append_define, name_ref, macro.value);
+          generator_ref.appended_types.emplace(index, name_ref);
         }
       } else
-        generator_ref.appended_constants.emplace(name_ref);
+        generator_ref.appended_constants.emplace(index, name_ref);
     }
     inline void operator()(vkma_xml::detail::type::enumeration const &) {
       if (tag == type_tag::core) {
-        if (!generator_ref.appended_types.contains(name_ref)) {
-          auto type = types_ref.append_child("type");
-          type.append_attribute("name").set_value(name_ref.data());
-          type.append_attribute("category").set_value("enum");
-          generator_ref.appended_types.emplace(name_ref);
+        if (!generator_ref.appended_types.contains(index)) {
+          generator_ref.emit(&emitter_t::append_enum_type, name_ref);
+          generator_ref.appended_types.emplace(index, name_ref);
         }
-      } else if (!generator_ref.appended_basetypes.contains(name_ref)) {
-        auto type = types_ref.append_child("type");
-        type.append_attribute("category").set_value("basetype");
-        type.append_child(pugi::node_pcdata).set_value("enum ");
-        type.append_child("name").append_child(pugi::node_pcdata).set_value(name_ref.data());
-        type.append_child(pugi::node_pcdata).set_value(";");
-        generator_ref.appended_basetypes.emplace(name_ref);
+      } else if (!generator_ref.appended_basetypes.contains(index)) {
+        generator_ref.emit(&emitter_t::append_basetype, "enum"sv, name_ref);
+        generator_ref.appended_basetypes.emplace(index, name_ref);
       }
     }
     inline void operator()(vkma_xml::detail::type::function const &function) {
       if (tag == type_tag::core) {
-        for (auto const &parameter : function.parameters)
-          if (auto iterator = generator_ref.api.registry.find(parameter.type.name);
+        for (auto const &parameter : *function.parameters)
+          if (auto iterator = generator_ref.api.registry.find(parameter.type.name());
               iterator != generator_ref.api.registry.end())
-            std::visit(append_types_visitor{ parameter.type.name, iterator->second.tag, types_ref,
-                                             generator_ref },
+            std::visit(append_types_visitor{ parameter.type.name(), iterator->second.tag,
+                                             iterator->second.index, generator_ref },
                        iterator->second.state);
-        if (auto iterator = generator_ref.api.registry.find(function.return_type.name);
+        if (auto iterator = generator_ref.api.registry.find(function.return_type.name());
             iterator != generator_ref.api.registry.end())
-          std::visit(append_types_visitor{ function.return_type.name, iterator->second.tag,
-                                           types_ref, generator_ref },
+          std::visit(append_types_visitor{ function.return_type.name(), iterator->second.tag,
+                                           iterator->second.index, generator_ref },
                      iterator->second.state);
       }
     }
     inline void operator()(vkma_xml::detail::type::function_pointer const &function_pointer) {
       if (tag == type_tag::core) {
-        if (!generator_ref.appended_types.contains(name_ref)) {
+        if (!generator_ref.appended_types.contains(index)) {
           for (auto const &parameter : function_pointer.parameters)
-            if (auto iterator = generator_ref.api.registry.find(parameter.type.name);
+            if (auto iterator = generator_ref.api.registry.find(parameter.type.name());
                 iterator != generator_ref.api.registry.end())
-              std::visit(append_types_visitor{ parameter.type.name, iterator->second.tag, types_ref,
-                                               generator_ref },
+              std::visit(append_types_visitor{ parameter.type.name(), iterator->second.tag,
+                                               iterator->second.index, generator_ref },
                          iterator->second.state);
-          if (auto iterator = generator_ref.api.registry.find(function_pointer.return_type.name);
+          if (auto iterator = generator_ref.api.registry.find(function_pointer.return_type.name());
               iterator != generator_ref.api.registry.end())
-            std::visit(append_types_visitor{ function_pointer.return_type.name,
-                                             iterator->second.tag, types_ref, generator_ref },
+            std::visit(append_types_visitor{ function_pointer.return_type.name(),
+                                             iterator->second.tag, iterator->second.index,
+                                             generator_ref },
                        iterator->second.state);
 
-          auto type = types_ref.append_child("type");
-          type.append_attribute("category").set_value("funcpointer");
-          type.append_child(pugi::node_pcdata)
-            .set_value(("typedef " + function_pointer.return_type.to_string() + "(*").data());
-          type.append_child("name").append_child(pugi::node_pcdata).set_value(name_ref.data());
-          type.append_child(pugi::node_pcdata).set_value(")(");
-          for (auto iterator = function_pointer.parameters.begin();
-               iterator != std::prev(function_pointer.parameters.end()); ++iterator) {
-            append_typename(type, iterator->type);
-            type.append_child(pugi::node_pcdata).set_value((" " + iterator->name + ", ").data());
-          }
-          append_typename(type, function_pointer.parameters.back().type);
-          type.append_child(pugi::node_pcdata)
-            .set_value((" " + function_pointer.parameters.back().name + ");").data());
-          generator_ref.appended_types.emplace(name_ref);
+          generator_ref.emit(&emitter_t::append_funcpointer, name_ref, function_pointer);
+          generator_ref.appended_types.emplace(index, name_ref);
         }
-      } else if (!generator_ref.appended_basetypes.contains(name_ref)) {
-        auto type = types_ref.append_child("type");
-        type.append_attribute("category").set_value("basetype");
-        type.append_child("name").append_child(pugi::node_pcdata).set_value(name_ref.data());
-        generator_ref.appended_basetypes.emplace(name_ref);
+      } else if (!generator_ref.appended_basetypes.contains(index)) {
+        generator_ref.emit(&emitter_t::append_basetype, ""sv, name_ref);
+        generator_ref.appended_basetypes.emplace(index, name_ref);
       }
     }
     inline void operator()(vkma_xml::detail::type::alias const &alias) {
       if (tag == type_tag::core) {
-        if (!generator_ref.appended_types.contains(name_ref))
-          if (std::string_view(name_ref).substr(name_ref.size() - 5) == "Flags"
-              && alias.real_type.name == "VkFlags") {
-            auto type = types_ref.append_child("type");
-            type.append_attribute("category").set_value("bitmask");
-            if (auto iterator = generator_ref.api.registry.find(
-                  name_ref.substr(0, name_ref.size() - 1) + "Bits");
+        if (!generator_ref.appended_types.contains(index))
+          if (auto bits = flag_bits_of(name_ref);
+              bits
+              && (alias.real_type.name() == "VkFlags" || alias.real_type.name() == "VkFlags64")) {
+            bool const is_64bit = alias.real_type.name() == "VkFlags64";
+            if (auto iterator = generator_ref.api.registry.find(*bits);
                 iterator != generator_ref.api.registry.end())
-              type.append_attribute("requires").set_value(iterator->first.data());
+              generator_ref.emit(&emitter_t::append_bitmask, name_ref,
+                                 std::optional<std::string_view>(iterator->first), is_64bit);
             else
-              type.append_attribute("requires").set_value("none");
-            type.append_child(pugi::node_pcdata).set_value("typedef ");
-            type.append_child("type").append_child(pugi::node_pcdata).set_value("VkFlags");
-            type.append_child(pugi::node_pcdata).set_value(" ");
-            type.append_child("name").append_child(pugi::node_pcdata).set_value(name_ref.data());
-            type.append_child(pugi::node_pcdata).set_value(";");
-            generator_ref.appended_types.insert(name_ref);
-          } else if (auto iterator = generator_ref.api.registry.find(alias.real_type.name);
+              generator_ref.emit(&emitter_t::append_bitmask, name_ref,
+                                 std::optional<std::string_view>(), is_64bit);
+            generator_ref.appended_types.emplace(index, name_ref);
+          } else if (auto iterator = generator_ref.api.registry.find(alias.real_type.name());
                      iterator != generator_ref.api.registry.end())
-            std::visit(append_types_visitor{ name_ref, tag, types_ref, generator_ref },
+            std::visit(append_types_visitor{ name_ref, tag, index, generator_ref },
                        iterator->second.state);
           else
-            std::cout << "Warning: An undefined aliased type: '" << alias.real_type.name << "'.\n";
-      } else if (!generator_ref.appended_basetypes.contains(name_ref))
-        if (auto iterator = generator_ref.api.registry.find(alias.real_type.name);
+            detail::message() << "Warning: An undefined aliased type: '" << alias.real_type.name()
+                              << "'.\n";
+      } else if (!generator_ref.appended_basetypes.contains(index))
+        if (auto iterator = generator_ref.api.registry.find(alias.real_type.name());
             iterator != generator_ref.api.registry.end()) {
-          std::visit(append_types_visitor{ alias.real_type.name, iterator->second.tag, types_ref,
-                                           generator_ref },
+          std::visit(append_types_visitor{ alias.real_type.name(), iterator->second.tag,
+                                           iterator->second.index, generator_ref },
                      iterator->second.state);
-          auto type = types_ref.append_child("type");
-          type.append_attribute("category").set_value("basetype");
-          type.append_child(pugi::node_pcdata).set_value("typedef ");
-          append_typename(type, alias.real_type);
-          type.append_child(pugi::node_pcdata).set_value(" ");
-          type.append_child("name").append_child(pugi::node_pcdata).set_value(name_ref.data());
-          type.append_child(pugi::node_pcdata).set_value(";");
-          generator_ref.appended_basetypes.emplace(name_ref);
+          generator_ref.emit(&emitter_t::append_typedef, name_ref, alias.real_type);
+          generator_ref.appended_basetypes.emplace(index, name_ref);
         }
     }
     inline void operator()(vkma_xml::detail::type::base const &) {
-      if (!generator_ref.appended_basetypes.contains(name_ref)) {
-        auto type = types_ref.append_child("type");
-        type.append_attribute("category").set_value("basetype");
-        type.append_child("name").append_child(pugi::node_pcdata).set_value(name_ref.data());
-        generator_ref.appended_basetypes.emplace(name_ref);
+      if (!generator_ref.appended_basetypes.contains(index)) {
+        generator_ref.emit(&emitter_t::append_basetype, ""sv, name_ref);
+        generator_ref.appended_basetypes.emplace(index, name_ref);
       }
     }
   };
 
-  if (registry) {
-    auto types = registry->append_child("types");
-    types.append_attribute("comment").set_value("VKMA type definitions");
-
-    auto required_comment = types.append_child("comment");
-    required_comment.append_child(pugi::node_pcdata).set_value("Why is a comment here required?!");
-
-    auto vma_include = types.append_child("type");
-    vma_include.append_attribute("name").set_value("vma");
-    vma_include.append_attribute("category").set_value("include");
-    vma_include.append_child(pugi::node_pcdata).set_value("#include \"vk_mem_alloc.h\"");
-
-    for (auto const &type : api.registry)
-      if (type.second.tag == type_tag::core)
-        std::visit(append_types_visitor{ type.first, type.second.tag, types, *this },
-                   type.second.state);
-  }
+  emit(&emitter_t::begin_types);
+  for (auto const *type : api.registry.entries())
+    if (type->second.tag == type_tag::core && is_selected(type->second.index)) {
+      // One span per top level entry: it includes the whole dependency recursion.
+      trace_span_t span("append_types_visitor");
+      if (span)
+        span.arg("name", type->first);
+      emit(&emitter_t::begin_root, std::string_view(type->first));
+      std::visit(append_types_visitor{ type->first, type->second.tag, type->second.index, *this },
+                 type->second.state);
+    }
 }
 
 void vkma_xml::detail::generator_t::append_enumerations() {
   struct append_enumerations_visitor {
     identifier_t const &name_ref;
     type_tag const &tag;
-    pugi::xml_node &registry_ref;
+    size_t index;
     generator_t &generator_ref;
 
     inline void operator()(vkma_xml::detail::type::undefined const &) {}
@@ -761,57 +1419,49 @@ void vkma_xml::detail::generator_t::append_enumerations() {
     inline void operator()(vkma_xml::detail::type::macro const &) {}
     inline void operator()(vkma_xml::detail::type::enumeration const &enumeration) {
       if (tag == type_tag::core) {
-        auto enums = registry_ref.append_child("enums");
-        enums.append_attribute("name").set_value(name_ref.data());
-        if (std::string_view(name_ref).substr(name_ref.size() - 8) == "FlagBits")
-          enums.append_attribute("type").set_value("bitmask");
-        else
-          enums.append_attribute("type").set_value("enum");
-        for (auto &enumerator : enumeration.values) {
-          auto enum_ = enums.append_child("enum");
-          enum_.append_attribute("value").set_value(enumerator.value.data());
-          enum_.append_attribute("name").set_value(enumerator.name.data());
-        }
-        for (auto &alias : enumeration.aliases) {
-          auto enum_ = enums.append_child("enum");
-          enum_.append_attribute("name").set_value(alias.name.data());
-          enum_.append_attribute("alias").set_value(alias.value.data());
-        }
+        bool const is_bitmask = is_flag_bits(name_ref);
+        bool const is_64bit =
+          is_bitmask
+          && ((enumeration.type && enumeration.type->name() == "VkFlags64")
+              || std::any_of(enumeration.values.begin(), enumeration.values.end(),
+                             [](constant_t const &enumerator) {
+                               return enumerator.number
+                                      && static_cast<std::uint64_t>(*enumerator.number)
+                                           > 0xFFFFFFFF;
+                             }));
+        generator_ref.emit(&emitter_t::append_enumeration, name_ref, enumeration, is_bitmask,
+                           is_64bit);
       }
     }
     inline void operator()(vkma_xml::detail::type::function const &) {}
     inline void operator()(vkma_xml::detail::type::function_pointer const &) {}
     inline void operator()(vkma_xml::detail::type::alias const &alias) {
       if (tag == type_tag::core)
-        if (auto iterator = generator_ref.api.registry.find(alias.real_type.name);
+        if (auto iterator = generator_ref.api.registry.find(alias.real_type.name());
             iterator != generator_ref.api.registry.end())
           if (std::holds_alternative<type::enumeration>(iterator->second.state))
-            std::visit(append_enumerations_visitor{ name_ref, tag, registry_ref, generator_ref },
+            std::visit(append_enumerations_visitor{ name_ref, tag, index, generator_ref },
                        iterator->second.state);
     }
     inline void operator()(vkma_xml::detail::type::base const &) {}
   };
 
-  if (registry) {
-    auto enums = registry->append_child("enums");
-    enums.append_attribute("name").set_value("API Constants");
-    enums.append_attribute("comment").set_value(
-      "Hardcoded constants - not an enumerated type, part of the header boilerplate");
-    for (auto const &constant_name : appended_constants)
-      if (auto iterator = api.registry.find(constant_name); iterator != api.registry.end())
-        if (std::holds_alternative<type::macro>(iterator->second.state)) {
-          auto enum_ = enums.append_child("enum");
-          enum_.append_attribute("value").set_value(
-            std::get<type::macro>(iterator->second.state).value.data());
-          enum_.append_attribute("name").set_value(constant_name.data());
-        } else
-          std::cout << "Ignore a constant(" << constant_name << "): its type is not supported.\n";
+  emit(&emitter_t::begin_enumerations);
+  for (auto const &constant_name : appended_constants)
+    if (auto iterator = api.registry.find(constant_name); iterator != api.registry.end())
+      if (std::holds_alternative<type::macro>(iterator->second.state))
+        emit(&emitter_t::append_constant, constant_name,
+             std::string_view(std::get<type::macro>(iterator->second.state).value));
       else
-        std::cout << "Warning: Ignore an unknown constant: " << constant_name << ".\n";
-    for (auto const &type : api.registry)
-      std::visit(append_enumerations_visitor{ type.first, type.second.tag, *registry, *this },
-                 type.second.state);
-  }
+        detail::message() << "Ignore a constant(" << constant_name
+                          << "): its type is not supported.\n";
+    else
+      detail::message() << "Warning: Ignore an unknown constant: " << constant_name << ".\n";
+  for (auto const *type : api.registry.entries())
+    if (is_selected(type->second.index))
+      std::visit(
+        append_enumerations_visitor{ type->first, type->second.tag, type->second.index, *this },
+        type->second.state);
 }
 
 std::string concatenate_success_codes(vkma_xml::detail::type_registry const &registry) {
@@ -822,12 +1472,14 @@ std::string concatenate_success_codes(vkma_xml::detail::type_registry const &reg
       if (!enumeration.values.empty())
         return enumeration.values.front().name;
       else
-        std::cout
-          << "Warning: Unable to select success codes: VkResult enumeration has no enumerators.";
+        vkma_xml::detail::message()
+          << "Warning: Unable to select success codes: VkResult enumeration has no enumerators.\n";
     } else
-      std::cout << "Warning: Unable to select success codes: VkResult is not an enumeration.";
+      vkma_xml::detail::message()
+        << "Warning: Unable to select success codes: VkResult is not an enumeration.\n";
   else
-    std::cout << "Warning: Unable to select success codes: VkResult is not defined.";
+    vkma_xml::detail::message()
+      << "Warning: Unable to select success codes: VkResult is not defined.\n";
   return "";
 }
 std::string concatenate_error_codes(vkma_xml::detail::type_registry const &registry) {
@@ -842,20 +1494,28 @@ std::string concatenate_error_codes(vkma_xml::detail::type_registry const &regis
           output += enumerator->name + ", ";
         return output += enumeration.values.back().name;
       } else
-        std::cout
-          << "Warning: Unable to select error codes: VkResult enumeration has no enumerators.";
+        vkma_xml::detail::message()
+          << "Warning: Unable to select error codes: VkResult enumeration has no enumerators.\n";
     } else
-      std::cout << "Warning: Unable to select error codes: VkResult is not an enumeration.";
+      vkma_xml::detail::message()
+        << "Warning: Unable to select error codes: VkResult is not an enumeration.\n";
   else
-    std::cout << "Warning: Unable to select error codes: VkResult is not defined.";
+    vkma_xml::detail::message()
+      << "Warning: Unable to select error codes: VkResult is not defined.\n";
   return "";
 }
 
+std::pair<std::string, std::string> const &vkma_xml::detail::generator_t::result_codes() {
+  if (!result_code_lists)
+    result_code_lists.emplace(concatenate_success_codes(api.registry),
+                              concatenate_error_codes(api.registry));
+  return *result_code_lists;
+}
 void vkma_xml::detail::generator_t::append_commands() {
   struct append_commands_visitor {
     identifier_t const &name_ref;
     type_tag const &tag;
-    pugi::xml_node &commands_ref;
+    size_t index;
     generator_t &generator_ref;
 
     inline void operator()(vkma_xml::detail::type::undefined const &) {}
@@ -864,135 +1524,260 @@ void vkma_xml::detail::generator_t::append_commands() {
     inline void operator()(vkma_xml::detail::type::macro const &) {}
     inline void operator()(vkma_xml::detail::type::enumeration const &) {}
     inline void operator()(vkma_xml::detail::type::function const &function) {
-      static auto success_code_list = concatenate_success_codes(generator_ref.api.registry);
-      static auto error_code_list = concatenate_error_codes(generator_ref.api.registry);
-
-      auto command = commands_ref.append_child("command");
-      if (function.return_type.name == "VkResult" || function.return_type.name == "VkmaResult") {
-        if (!success_code_list.empty())
-          command.append_attribute("successcodes").set_value(success_code_list.data());
-        if (!error_code_list.empty())
-          command.append_attribute("errorcodes").set_value(error_code_list.data());
-      }
-      auto proto = command.append_child("proto");
-      append_typename(proto, function.return_type);
-      proto.append_child(pugi::node_pcdata).set_value(" ");
-      proto.append_child("name").append_child(pugi::node_pcdata).set_value(name_ref.data());
-
-      for (auto &parameter : function.parameters) {
-        auto param = command.append_child("param");
-        append_typename(param, parameter.type);
-        param.append_child(pugi::node_pcdata).set_value(" ");
-        param.append_child("name").append_child(pugi::node_pcdata).set_value(parameter.name.data());
-      }
-      generator_ref.appended_commands.emplace(name_ref);
+      auto const &[success_code_list, error_code_list] = generator_ref.result_codes();
+
+      if (function.return_type.name() == "VkResult" || function.return_type.name() == "VkmaResult")
+        generator_ref.emit(&emitter_t::append_command, name_ref, function,
+                           std::string_view(success_code_list), std::string_view(error_code_list));
+      else
+        generator_ref.emit(&emitter_t::append_command, name_ref, function, ""sv, ""sv);
+      generator_ref.appended_commands.emplace(index, name_ref);
     }
     inline void operator()(vkma_xml::detail::type::function_pointer const &) {}
     inline void operator()(vkma_xml::detail::type::alias const &) {}
     inline void operator()(vkma_xml::detail::type::base const &) {}
   };
 
-  if (registry) {
-    auto commands = registry->append_child("commands");
-    commands.append_attribute("comment").set_value("VKMA command definitions");
-    for (auto const &type : api.registry)
-      if (type.second.tag == type_tag::core)
-        std::visit(append_commands_visitor{ type.first, type.second.tag, commands, *this },
-                   type.second.state);
-  }
+  emit(&emitter_t::begin_commands);
+  for (auto const *type : api.registry.entries())
+    if (type->second.tag == type_tag::core && is_selected(type->second.index)) {
+      emit(&emitter_t::begin_root, std::string_view(type->first));
+      std::visit(
+        append_commands_visitor{ type->first, type->second.tag, type->second.index, *this },
+        type->second.state);
+    }
 }
 
 void vkma_xml::detail::generator_t::append_feature() {
-  if (registry) {
-    auto feature = registry->append_child("feature");
-    feature.append_attribute("api").set_value("vkma");
-    feature.append_attribute("name").set_value("VKMA_VERSION_3_0_1");
-    feature.append_attribute("number").set_value("3.0.1");
-    feature.append_attribute("comment").set_value("VKMA API interface definitions");
-
-    if (registry) {
-      auto required = feature.append_child("require");
-      required.append_attribute("comment").set_value("a mess, isn't it?");
-      required.append_child("type").append_attribute("name").set_value("vma");
-
-      for (auto const &type_name : appended_types) {
-        auto type = required.append_child("type");
-        type.append_attribute("name").set_value(type_name.data());
-      }
-      for (auto const &command_name : appended_commands) {
-        auto command = required.append_child("command");
-        command.append_attribute("name").set_value(command_name.data());
-      }
-    }
-  }
+  emit(&emitter_t::append_feature, appended_types, appended_commands);
 }
 
-void vkma_xml::detail::generator_t::append_footer() {
-  if (registry) {
-    auto extensions = registry->append_child("extensions");
-    extensions.append_attribute("comment").set_value("empty");
-    auto extension = extensions.append_child("extension");
-    extension.append_attribute("name").set_value("VK_WC_why_y_y_y_y");
-    extension.append_attribute("number").set_value("1");
-    extension.append_attribute("type").set_value("instance");
-    extension.append_attribute("author").set_value("WC");
-    extension.append_attribute("contact").set_value("@cvelth");
-    extension.append_attribute("supported").set_value("disabled");
-    auto spirvextensions = registry->append_child("spirvextensions");
-    spirvextensions.append_attribute("comment").set_value("empty");
-    auto spirvcapabilities = registry->append_child("spirvcapabilities");
-    spirvcapabilities.append_attribute("comment").set_value("empty");
-  }
-}
+void vkma_xml::detail::generator_t::append_footer() { emit(&emitter_t::end); }
 
 std::optional<pugi::xml_document> vkma_xml::generate(detail::api_t const &api) {
-  detail::generator_t generator = api;
-
-  generator.append_header();
-  generator.append_types();
-  generator.append_enumerations();
-  generator.append_commands();
-  generator.append_feature();
-  generator.append_footer();
-
-  return std::move(generator.output);
+  return generate(api, std::vector<std::string_view>{});
+}
+std::optional<pugi::xml_document>
+vkma_xml::generate(detail::api_t const &api, std::vector<std::string_view> const &roots) {
+  detail::xml_emitter_t emitter;
+  if (!generate(api, { &emitter }, roots))
+    return std::nullopt;
+  return std::move(emitter.output);
+}
+bool vkma_xml::generate(detail::api_t const &api,
+                        std::vector<detail::emitter_t *> const &emitters,
+                        std::vector<std::string_view> const &roots) {
+  detail::generator_t generator(api, emitters);
+  if (!roots.empty())
+    generator.select(roots);
+
+  detail::trace_span_t span("generate");
+  static constexpr size_t pass_count = 7;
+  size_t done = 0;
+  auto run = [&generator, &done](char const *name, auto pass) {
+    if (detail::is_stop_requested())
+      return false;
+    detail::trace_span_t pass_span(name);
+    (generator.*pass)();
+    detail::report_progress(name, ++done, pass_count);
+    return true;
+  };
+  return run("append_header", &detail::generator_t::append_header)
+         && run("append_types", &detail::generator_t::append_types)
+         && run("append_enumerations", &detail::generator_t::append_enumerations)
+         && run("result_codes", &detail::generator_t::result_codes)
+         && run("append_commands", &detail::generator_t::append_commands)
+         && run("append_feature", &detail::generator_t::append_feature)
+         && run("append_footer", &detail::generator_t::append_footer);
 }
 
 #ifndef VMA_XML_NO_MAIN
-int main() {
-  std::filesystem::path const vkma_bindings_directory = "../xml/vkma_bindings";
-  std::vector<std::filesystem::path> const vkma_bindings_header_files = {
-    "../input/vkma_bindings/include/vkma_bindings.hpp"
+int main(int argc, char **argv) {
+  // '--headers' reads declarations directly from the header files instead of doxygen xml.
+  // '--root <pattern>' (repeatable) limits the output to what the matching entries depend on.
+  // '--format <xml|json|explain>' (repeatable) selects the outputs, all produced in a single pass.
+  // 'explain' reports which root entity pulled each element in and what every root costs.
+  // '--trace <path>' records a Chrome trace-event timeline of the run.
+  // '--diff <path>' reports what changed since the checkout at <path> instead of generating.
+  // '--merge <vk.xml>' also writes a copy of <vk.xml> with the registry spliced into it.
+  // '--core <vma|vulkan>' (repeatable) emits that helper api in full, not just what is used.
+  // '--shard <k>/<n>' only parses part <k> (from 0) out of <n> and saves the partial registry.
+  // '--merge-shards <n>' generates from the <n> partial registries instead of parsing.
+  bool use_headers = false;
+  std::vector<std::string_view> roots;
+  std::set<std::string_view> formats;
+  std::optional<std::filesystem::path> trace_path;
+  std::optional<std::filesystem::path> diff_path;
+  std::optional<std::filesystem::path> merge_path;
+  std::set<std::string_view> core_apis;
+  std::optional<vkma_xml::detail::shard_t> shard;
+  std::optional<size_t> shard_count;
+  auto to_number = [](std::string_view text) -> std::optional<size_t> {
+    size_t output;
+    if (auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), output);
+        error == std::errc{} && end == text.data() + text.size())
+      return output;
+    return std::nullopt;
   };
-
-  std::filesystem::path const vma_directory = "../xml/VulkanMemoryAllocator";
-  std::vector<std::filesystem::path> const vma_header_files = {
-    "../input/VulkanMemoryAllocator/include/vk_mem_alloc.h"
+  for (int i = 1; i < argc; ++i)
+    if (argv[i] == "--headers"sv)
+      use_headers = true;
+    else if (argv[i] == "--root"sv && i + 1 < argc)
+      roots.emplace_back(argv[++i]);
+    else if (argv[i] == "--format"sv && i + 1 < argc)
+      formats.emplace(argv[++i]);
+    else if (argv[i] == "--trace"sv && i + 1 < argc) {
+      trace_path = argv[++i];
+      vkma_xml::enable_trace();
+    } else if (argv[i] == "--diff"sv && i + 1 < argc)
+      diff_path = argv[++i];
+    else if (argv[i] == "--merge"sv && i + 1 < argc)
+      merge_path = argv[++i];
+    else if (argv[i] == "--core"sv && i + 1 < argc)
+      core_apis.emplace(argv[++i]);
+    else if (argv[i] == "--shard"sv && i + 1 < argc) {
+      std::string_view value = argv[++i];
+      auto index = to_number(value.substr(0, value.find('/')));
+      auto count = value.find('/') != std::string_view::npos
+                     ? to_number(value.substr(value.find('/') + 1))
+                     : std::nullopt;
+      if (index && count && *index < *count)
+        shard = vkma_xml::detail::shard_t{ *index, *count };
+      else
+        std::cout << "Warning: Ignore an invalid shard: '" << value << "'.\n";
+    } else if (argv[i] == "--merge-shards"sv && i + 1 < argc) {
+      if (shard_count = to_number(argv[++i]); !shard_count || *shard_count == 0)
+        std::cout << "Warning: Ignore an invalid shard count: '" << argv[i] << "'.\n";
+    } else
+      std::cout << "Warning: Ignore an unknown argument: '" << argv[i] << "'.\n";
+
+  // 'root' holds the 'xml' and 'input' directories.
+  auto parse_checkout = [use_headers, &core_apis, &shard](std::filesystem::path const &root) {
+    std::filesystem::path const vkma_bindings_directory = root / "xml/vkma_bindings";
+    std::vector<std::filesystem::path> const vkma_bindings_header_files = {
+      root / "input/vkma_bindings/include/vkma_bindings.hpp"
+    };
+
+    std::filesystem::path const vma_directory = root / "xml/VulkanMemoryAllocator";
+    std::vector<std::filesystem::path> const vma_header_files = {
+      root / "input/VulkanMemoryAllocator/include/vk_mem_alloc.h"
+    };
+
+    std::filesystem::path const vulkan_directory = root / "xml/Vulkan-Headers";
+    std::vector<std::filesystem::path> const vulkan_header_files = {
+      root / "input/Vulkan-Headers/include/vulkan/vulkan_core.h",
+      root / "input/Vulkan-Headers/include/vulkan/vk_platform.h"
+    };
+
+    vkma_xml::input const main_api{ .xml_directory = vkma_bindings_directory,
+                                    .header_files = vkma_bindings_header_files };
+    vkma_xml::input const vma_api{ .xml_directory = vma_directory,
+                                   .header_files = vma_header_files,
+                                   .is_core = core_apis.contains("vma") };
+    vkma_xml::input const vulkan_api{ .xml_directory = vulkan_directory,
+                                      .header_files = vulkan_header_files,
+                                      .is_core = core_apis.contains("vulkan") };
+
+    std::vector<vkma_xml::input const *> const inputs = { &main_api, &vma_api, &vulkan_api };
+    return use_headers ? vkma_xml::detail::parse_headers(inputs, shard)
+                       : vkma_xml::detail::parse(inputs, shard);
   };
-
-  std::filesystem::path const vulkan_directory = "../xml/Vulkan-Headers";
-  std::vector<std::filesystem::path> const vulkan_header_files = {
-    "../input/Vulkan-Headers/include/vulkan/vulkan_core.h",
-    "../input/Vulkan-Headers/include/vulkan/vk_platform.h"
+  std::filesystem::path const output_directory = "../output";
+  auto shard_path = [&output_directory](size_t index, size_t count) {
+    return output_directory
+           / ("vkma." + std::to_string(index) + "-" + std::to_string(count) + ".shard");
   };
 
-  std::filesystem::path const output_path = "../output/vkma.xml";
+  if (shard) {
+    auto api = parse_checkout("..");
+    std::filesystem::create_directory(output_directory);
+    auto path = shard_path(shard->index, shard->count);
+    if (!api)
+      std::cout << "Error: Parsing failed.";
+    else if (vkma_xml::save_shard(*api, path))
+      std::cout << "Success: " << std::filesystem::absolute(path) << "\n";
+    else
+      std::cout << "Error: Unable to save " << std::filesystem::absolute(path) << ".";
+    return 0;
+  }
 
-  auto output = vkma_xml::generate(vkma_xml::input{ .xml_directory = vkma_bindings_directory,
-                                                    .header_files = vkma_bindings_header_files },
-                                   vkma_xml::input{ .xml_directory = vma_directory,
-                                                    .header_files = vma_header_files },
-                                   vkma_xml::input{ .xml_directory = vulkan_directory,
-                                                    .header_files = vulkan_header_files });
+  std::optional<vkma_xml::detail::api_t> api;
+  if (shard_count) {
+    std::vector<std::filesystem::path> paths;
+    for (size_t i = 0; i < *shard_count; ++i)
+      paths.emplace_back(shard_path(i, *shard_count));
+    api = vkma_xml::merge_shards(paths);
+  } else
+    api = parse_checkout("..");
+  if (diff_path) {
+    if (auto before = parse_checkout(*diff_path); before && api) {
+      auto difference = vkma_xml::diff(*before, *api);
+      auto print = [](std::string_view title, std::vector<std::string> const &names) {
+        std::cout << title << " (" << names.size() << "):\n";
+        for (auto const &name : names)
+          std::cout << "  " << name << "\n";
+      };
+      print("Added", difference.added);
+      print("Removed", difference.removed);
+      print("Changed", difference.changed);
+      std::cout << "Compared " << difference.compared << " of " << api->registry.size()
+                << " entries.\n";
+    } else
+      std::cout << "Error: Diff failed.";
+    return 0;
+  }
 
-  if (output) {
-    std::filesystem::create_directory(output_path.parent_path());
-    if (auto result = output->save_file(output_path.c_str()); result)
-      std::cout << "\nSuccess: " << std::filesystem::absolute(output_path) << "\n";
+  if (formats.empty() && !merge_path)
+    formats.emplace("xml");
+  std::vector<std::pair<std::unique_ptr<vkma_xml::detail::emitter_t>, std::filesystem::path>>
+    outputs;
+  for (auto const &format : formats)
+    if (format == "xml")
+      outputs.emplace_back(std::make_unique<vkma_xml::detail::xml_emitter_t>(),
+                           output_directory / "vkma.xml");
+    else if (format == "json")
+      outputs.emplace_back(std::make_unique<vkma_xml::detail::json_emitter_t>(),
+                           output_directory / "vkma.json");
+    else if (format == "explain") {
+      if (api)
+        outputs.emplace_back(std::make_unique<vkma_xml::detail::explain_emitter_t>(*api),
+                             output_directory / "vkma.explain.txt");
+    }
     else
-      std::cout << "Error: Unable to save " << std::filesystem::absolute(output_path) << ".";
+      std::cout << "Warning: Ignore an unknown output format: '" << format << "'.\n";
+  if (merge_path)
+    outputs.emplace_back(std::make_unique<vkma_xml::detail::merge_emitter_t>(*merge_path),
+                         output_directory / "vk.xml");
+
+  if (api) {
+    std::vector<vkma_xml::detail::emitter_t *> emitters;
+    for (auto const &output : outputs)
+      emitters.emplace_back(output.first.get());
+    vkma_xml::generate(*api, emitters, roots);
+
+    // Outputs are saved concurrently, but reported in order.
+    std::filesystem::create_directory(output_directory);
+    std::vector<char> is_saved(outputs.size());
+    vkma_xml::detail::task_graph_t graph;
+    for (size_t i = 0; i < outputs.size(); ++i)
+      graph.add("save", [&outputs, &is_saved, i] {
+        is_saved[i] = outputs[i].first->save(outputs[i].second);
+      });
+    graph.run();
+    for (size_t i = 0; i < outputs.size(); ++i)
+      if (is_saved[i])
+        std::cout << "\nSuccess: " << std::filesystem::absolute(outputs[i].second) << "\n";
+      else
+        std::cout << "Error: Unable to save " << std::filesystem::absolute(outputs[i].second)
+                  << ".";
   } else
     std::cout << "Error: Generation failed.";
+
+  if (trace_path)
+    if (vkma_xml::save_trace(*trace_path))
+      std::cout << "Trace: " << std::filesystem::absolute(*trace_path) << "\n";
+    else
+      std::cout << "Error: Unable to save " << std::filesystem::absolute(*trace_path) << ".";
   return 0;
 }
 #endif
@@ -12,26 +12,19 @@
   #pragma warning(pop)
 #endif
 
+#include <algorithm>
+#include <cctype>
 #include <filesystem>
-#include <fstream>
-#include <iostream>
 #include <map>
 #include <optional>
 #include <string_view>
 #include <vector>
-using namespace std::string_view_literals;
 
-namespace vkma_xml::detail {
-  using identifier_t = std::string;
-  namespace type {
-    struct handle {
-      bool dispatchable;
-      std::optional<identifier_t> parent;
-    };
-  } // namespace type
-  std::map<identifier_t, type::handle>
-  load_handle_list(std::vector<std::filesystem::path> const &files);
-} // namespace vkma_xml::detail
+#include "async.hpp"
+#include "generator.hpp"
+#include "task_graph.hpp"
+#include "trace.hpp"
+using namespace std::string_view_literals;
 
 static constexpr auto handle_pattern = ctll::fixed_string{
   R"(VK_DEFINE_HANDLE\(([A-Za-z_0-9]+)\))"
@@ -62,17 +55,641 @@ std::map<vkma_xml::detail::identifier_t, vkma_xml::detail::type::handle>
 vkma_xml::detail::load_handle_list(std::vector<std::filesystem::path> const &files) {
   std::map<identifier_t, type::handle> output;
   for (auto const &file : files)
-    if (std::ifstream stream(file, std::fstream::ate); stream) {
-      size_t source_size = stream.tellg();
-      std::string source(source_size, '\0');
-      stream.seekg(0);
-      stream.read(source.data(), source_size);
-
-      append_handles<handle_pattern>(source, true, output);
-      append_handles<nd_handle_pattern>(source, false, output);
+    if (auto source = load_text(file); source) {
+      trace_span_t span("load_handle_list");
+      if (span)
+        span.arg("file", file.string()).arg("bytes", source->size());
+      append_handles<handle_pattern>(*source, true, output);
+      append_handles<nd_handle_pattern>(*source, false, output);
+    }
+
+  return output;
+}
+
+static bool is_identifier(char character) {
+  return std::isalnum(static_cast<unsigned char>(character)) || character == '_';
+}
+static std::string_view trim(std::string_view input) {
+  while (!input.empty() && std::isspace(static_cast<unsigned char>(input.front())))
+    input.remove_prefix(1);
+  while (!input.empty() && std::isspace(static_cast<unsigned char>(input.back())))
+    input.remove_suffix(1);
+  return input;
+}
+static std::string_view read_identifier(std::string_view input) {
+  size_t size = 0;
+  while (size < input.size() && is_identifier(input[size]))
+    ++size;
+  return input.substr(0, size);
+}
+static std::string_view last_identifier(std::string_view input) {
+  input = trim(input);
+  size_t begin = input.size();
+  while (begin > 0 && is_identifier(input[begin - 1]))
+    --begin;
+  return input.substr(begin);
+}
+static size_t find_closing(std::string_view input, size_t position, char open, char close) {
+  for (size_t depth = 0; position < input.size(); ++position)
+    if (input[position] == open)
+      ++depth;
+    else if (input[position] == close && --depth == 0)
+      return position;
+  return std::string_view::npos;
+}
+static std::vector<std::string_view> split(std::string_view input, char separator) {
+  std::vector<std::string_view> output;
+  size_t depth = 0, begin = 0;
+  for (size_t i = 0; i < input.size(); ++i)
+    if (input[i] == '(' || input[i] == '{' || input[i] == '[')
+      ++depth;
+    else if ((input[i] == ')' || input[i] == '}' || input[i] == ']') && depth)
+      --depth;
+    else if (input[i] == separator && !depth) {
+      if (auto entry = trim(input.substr(begin, i - begin)); !entry.empty())
+        output.emplace_back(entry);
+      begin = i + 1;
+    }
+  if (auto entry = trim(input.substr(begin)); !entry.empty())
+    output.emplace_back(entry);
+  return output;
+}
+
+// Removes comments and line continuations. Keeps line breaks so that directives stay separate.
+static std::string strip_comments(std::string_view source) {
+  std::string output;
+  output.reserve(source.size());
+  for (size_t i = 0; i < source.size(); ++i)
+    if (source.substr(i, 2) == "//"sv) {
+      while (i < source.size() && source[i] != '\n')
+        i += source.substr(i, 2) == "\\\n"sv ? 2 : 1;
+      output += '\n';
+    } else if (source.substr(i, 2) == "/*"sv) {
+      i = source.find("*/", i + 2);
+      if (i == std::string_view::npos)
+        break;
+      ++i;
+      output += ' ';
+    } else if (source.substr(i, 2) == "\\\n"sv)
+      ++i;
+    else if (source.substr(i, 3) == "\\\r\n"sv)
+      i += 2;
+    else if (source[i] == '"' || source[i] == '\'') {
+      auto quote = source[i];
+      output += source[i];
+      while (++i < source.size() && source[i] != quote && source[i] != '\n') {
+        if (source[i] == '\\' && i + 1 < source.size())
+          output += source[i++];
+        output += source[i];
+      }
+      if (i < source.size())
+        output += source[i];
     } else
-      std::cout << "Error: Ignore '" << std::filesystem::absolute(file)
-                << "'. Unable to read it. Make sure it exists and is accessible.";
+      output += source[i];
+  return output;
+}
+
+// Collapses whitespace, erases the macros doxygen is configured to expand to nothing and
+// places pointer declarators the way doxygen prints them: 'type *name'.
+static std::string normalize(std::string_view input, bool expand_macros = true) {
+  std::string output;
+  output.reserve(input.size());
+  for (size_t i = 0; i < input.size();)
+    if (is_identifier(input[i])) {
+      auto identifier = read_identifier(input.substr(i));
+      i += identifier.size();
+      if (!expand_macros || !vkma_xml::detail::ignored_macros.contains(identifier))
+        output += identifier;
+      else if (auto next = input.find_first_not_of(" \t\r\n", i);
+               next != std::string_view::npos && input[next] == '(')
+        if (auto close = find_closing(input, next, '(', ')'); close != std::string_view::npos)
+          i = close + 1;
+    } else if (std::isspace(static_cast<unsigned char>(input[i++]))) {
+      if (!output.empty() && output.back() != ' ')
+        output += ' ';
+    } else {
+      if (input[i - 1] == '*' && !output.empty() && is_identifier(output.back()))
+        output += ' ';
+      output += input[i - 1];
+    }
+
+  std::string result;
+  result.reserve(output.size());
+  for (size_t i = 0; i < output.size(); ++i)
+    if (output[i] == ',') {
+      result += ", ";
+      if (i + 1 < output.size() && output[i + 1] == ' ')
+        ++i;
+    } else if (output[i] != ' ')
+      result += output[i];
+    else if (!result.empty() && i + 1 < output.size() && result.back() != '('
+             && result.back() != '[' && output[i + 1] != ')' && output[i + 1] != ']'
+             && output[i + 1] != ','
+             && (result.back() != '*' || (!is_identifier(output[i + 1]) && output[i + 1] != '*')))
+      result += ' ';
+  while (!result.empty() && result.back() == ' ')
+    result.pop_back();
+  return result;
+}
+
+namespace {
+  struct preprocessor_t {
+    std::unordered_map<std::string, std::string> macros;
+    std::vector<std::pair<bool, bool>> conditions; // { is_active, was_taken }
+
+    bool is_active() const {
+      for (auto const &condition : conditions)
+        if (!condition.first)
+          return false;
+      return true;
+    }
+    // 'std::nullopt' if the expression is malformed or the macros nest too deep. A macro stands
+    // for the value of its body, an empty one for 1.
+    std::optional<std::int64_t> evaluate(std::string_view expression, size_t depth = 0) const {
+      if (depth > 16)
+        return std::nullopt;
+      std::string substituted;
+      for (size_t i = 0; i < expression.size();)
+        if (expression.substr(i, 7) == "defined"sv
+            && (i == 0 || !is_identifier(expression[i - 1]))
+            && (i + 7 == expression.size() || !is_identifier(expression[i + 7]))) {
+          auto rest = trim(expression.substr(i + 7));
+          bool in_parentheses = !rest.empty() && rest.front() == '(';
+          if (in_parentheses)
+            rest = trim(rest.substr(1));
+          auto name = read_identifier(rest);
+          if (name.empty())
+            return std::nullopt;
+          substituted += macros.contains(std::string(name)) ? " 1 " : " 0 ";
+          i = name.data() + name.size() - expression.data();
+          if (in_parentheses) {
+            i = expression.find(')', i);
+            if (i == std::string_view::npos)
+              return std::nullopt;
+            ++i;
+          }
+        } else
+          substituted += expression[i++];
+
+      return vkma_xml::detail::evaluate_expression(
+        substituted, [this, depth](std::string_view name) -> std::optional<std::int64_t> {
+          if (auto iterator = macros.find(std::string(name)); iterator != macros.end())
+            return trim(iterator->second).empty() ? 1 : evaluate(iterator->second, depth + 1);
+          return 0;
+        });
+    }
+    bool is_true(std::string_view expression) const {
+      auto result = evaluate(expression);
+      return result && *result;
+    }
+
+    // Returns true if the line was a directive.
+    bool process(std::string_view line,
+                 std::vector<std::pair<std::string, std::string>> &defines) {
+      line = trim(line);
+      if (line.empty() || line.front() != '#')
+        return false;
+      line = trim(line.substr(1));
+      auto directive = read_identifier(line);
+      auto argument = trim(line.substr(directive.size()));
+      if (directive == "if"sv)
+        conditions.emplace_back(is_active() && is_true(argument), false);
+      else if (directive == "ifdef"sv || directive == "ifndef"sv)
+        conditions.emplace_back(macros.contains(std::string(read_identifier(argument)))
+                                  == (directive == "ifdef"sv),
+                                false);
+      else if (directive == "elif"sv || directive == "else"sv) {
+        if (!conditions.empty()) {
+          auto &[active, taken] = conditions.back();
+          taken = taken || active;
+          conditions.pop_back();
+          bool parent_active = is_active();
+          conditions.emplace_back(
+            !taken && parent_active && (directive == "else"sv || is_true(argument)), taken);
+        }
+      } else if (directive == "endif"sv) {
+        if (!conditions.empty())
+          conditions.pop_back();
+      } else if (is_active())
+        if (directive == "define"sv) {
+          auto name = read_identifier(argument);
+          auto value = argument.substr(name.size());
+          if (!value.empty() && value.front() == '(')
+            if (auto close = value.find(')'); close != std::string_view::npos)
+              value = value.substr(close + 1);
+          value = trim(value);
+          macros.insert_or_assign(std::string(name), std::string(value));
+          if (!name.empty() && !value.empty())
+            defines.emplace_back(name, normalize(value, false));
+        } else if (directive == "undef"sv)
+          macros.erase(std::string(read_identifier(argument)));
+      return true;
+    }
+  };
+} // namespace
 
+std::optional<std::int64_t> vkma_xml::detail::evaluate_expression(
+  std::string_view expression,
+  std::function<std::optional<std::int64_t>(std::string_view)> const &lookup) {
+  // Values are computed in 'std::uint64_t', where overflow wraps around, and only read as
+  // signed where the sign matters. Shifts by a negative or too large count and
+  // 'INT64_MIN / -1' fail instead.
+  struct parser_t {
+    std::string_view input;
+    std::function<std::optional<std::int64_t>(std::string_view)> const &lookup;
+    bool failed = false;
+
+    static std::int64_t as_signed(std::uint64_t value) { return static_cast<std::int64_t>(value); }
+
+    void skip() {
+      while (!input.empty() && std::isspace(static_cast<unsigned char>(input.front())))
+        input.remove_prefix(1);
+    }
+    bool consume(std::string_view token) {
+      skip();
+      if (input.substr(0, token.size()) != token)
+        return false;
+      if (token.size() == 1 && input.size() > 1
+          && (((token == "|"sv || token == "&"sv) && input[1] == token[0])
+              || ((token == "<"sv || token == ">"sv) && (input[1] == token[0] || input[1] == '='))
+              || (token == "!"sv && input[1] == '=')))
+        return false;
+      input.remove_prefix(token.size());
+      return true;
+    }
+    std::uint64_t primary() {
+      skip();
+      if (consume("(")) {
+        auto value = binary(0);
+        if (!consume(")"))
+          failed = true;
+        return value;
+      } else if (consume("!"))
+        return !primary();
+      else if (consume("~"))
+        return ~primary();
+      else if (consume("-"))
+        return 0 - primary();
+      else if (consume("+"))
+        return primary();
+      else if (!input.empty() && std::isdigit(static_cast<unsigned char>(input.front()))) {
+        std::uint64_t value = 0;
+        size_t size = 0;
+        int base = input.substr(0, 2) == "0x"sv || input.substr(0, 2) == "0X"sv ? 16
+                   : input.front() == '0'                                       ? 8
+                                                                                : 10;
+        if (base == 16)
+          size = 2;
+        for (; size < input.size(); ++size)
+          if (auto c = std::tolower(static_cast<unsigned char>(input[size]));
+              std::isdigit(c) && c - '0' < base)
+            value = value * base + (c - '0');
+          else if (base == 16 && c >= 'a' && c <= 'f')
+            value = value * base + (c - 'a' + 10);
+          else
+            break;
+        while (size < input.size()
+               && (std::tolower(input[size]) == 'u' || std::tolower(input[size]) == 'l'))
+          ++size;
+        if (size < input.size() && (is_identifier(input[size]) || input[size] == '.'))
+          failed = true;
+        input.remove_prefix(size);
+        return value;
+      } else if (auto name = read_identifier(input); !name.empty()) {
+        input.remove_prefix(name.size());
+        if (auto value = lookup(name); value)
+          return static_cast<std::uint64_t>(*value);
+        failed = true;
+        return 0;
+      }
+      failed = true;
+      return 0;
+    }
+    std::uint64_t binary(int precedence) {
+      static constexpr std::array operators = {
+        std::pair{ "||"sv, 1 }, std::pair{ "&&"sv, 2 }, std::pair{ "|"sv, 3 },
+        std::pair{ "^"sv, 4 },  std::pair{ "&"sv, 5 },  std::pair{ "=="sv, 6 },
+        std::pair{ "!="sv, 6 }, std::pair{ "<="sv, 7 }, std::pair{ ">="sv, 7 },
+        std::pair{ "<<"sv, 8 }, std::pair{ ">>"sv, 8 }, std::pair{ "<"sv, 7 },
+        std::pair{ ">"sv, 7 },  std::pair{ "+"sv, 9 },  std::pair{ "-"sv, 9 },
+        std::pair{ "*"sv, 10 }, std::pair{ "/"sv, 10 }, std::pair{ "%"sv, 10 }
+      };
+      auto left = primary();
+      while (!failed) {
+        auto operation = std::find_if(operators.begin(), operators.end(), [&](auto const &op) {
+          return op.second > precedence && consume(op.first);
+        });
+        if (operation == operators.end())
+          break;
+        auto right = binary(operation->second);
+        if (operation->first == "||"sv) left = left || right;
+        else if (operation->first == "&&"sv) left = left && right;
+        else if (operation->first == "|"sv) left = left | right;
+        else if (operation->first == "^"sv) left = left ^ right;
+        else if (operation->first == "&"sv) left = left & right;
+        else if (operation->first == "=="sv) left = left == right;
+        else if (operation->first == "!="sv) left = left != right;
+        else if (operation->first == "<="sv) left = as_signed(left) <= as_signed(right);
+        else if (operation->first == ">="sv) left = as_signed(left) >= as_signed(right);
+        else if ((operation->first == "<<"sv || operation->first == ">>"sv) && right > 63)
+          failed = true; // Negative counts included, they are large as unsigned.
+        else if (operation->first == "<<"sv) left = left << right;
+        else if (operation->first == ">>"sv)
+          left = static_cast<std::uint64_t>(as_signed(left) >> right);
+        else if (operation->first == "<"sv) left = as_signed(left) < as_signed(right);
+        else if (operation->first == ">"sv) left = as_signed(left) > as_signed(right);
+        else if (operation->first == "+"sv) left = left + right;
+        else if (operation->first == "-"sv) left = left - right;
+        else if (operation->first == "*"sv) left = left * right;
+        else if (right == 0 || (as_signed(left) == INT64_MIN && as_signed(right) == -1))
+          failed = true;
+        else if (operation->first == "/"sv)
+          left = static_cast<std::uint64_t>(as_signed(left) / as_signed(right));
+        else left = static_cast<std::uint64_t>(as_signed(left) % as_signed(right));
+      }
+      return left;
+    }
+  } parser{ expression, lookup };
+
+  auto value = parser.binary(0);
+  parser.skip();
+  if (parser.failed || !parser.input.empty())
+    return std::nullopt;
+  return parser_t::as_signed(value);
+}
+
+static std::vector<vkma_xml::detail::variable_t> load_parameters(std::string_view parameters) {
+  std::vector<vkma_xml::detail::variable_t> output;
+  for (auto parameter : split(parameters, ','))
+    if (parameter = trim(parameter.substr(0, parameter.find('[')));
+        parameter != "void"sv && parameter != "..."sv)
+      if (auto name = last_identifier(parameter); !name.empty())
+        if (auto type = trim(parameter.substr(0, parameter.size() - name.size())); !type.empty())
+          output.emplace_back(std::string(name), std::string(type));
   return output;
 }
+
+static std::vector<vkma_xml::detail::variable_t> load_struct_body(std::string_view body,
+                                                                  std::string_view name) {
+  std::vector<vkma_xml::detail::variable_t> output;
+  for (auto member : split(body, ';'))
+    if (member.find('{') != std::string_view::npos)
+      vkma_xml::detail::message() << "Warning: Ignore a nested declaration inside '" << name
+                                  << "'.\n";
+    else {
+      auto args_begin = std::min(member.find('['), member.find(':'));
+      auto args = args_begin == std::string_view::npos ? ""sv : member.substr(args_begin);
+      member = trim(member.substr(0, args_begin));
+      if (auto member_name = last_identifier(member); !member_name.empty()) {
+        auto member_type = trim(member.substr(0, member.size() - member_name.size()));
+        output.emplace_back(vkma_xml::detail::api_t::make_variable(
+          std::string(member_name), std::string(member_type), normalize(args)));
+      }
+    }
+  return output;
+}
+
+void vkma_xml::detail::api_t::load_header(std::string_view source, type_tag tag,
+                                          sharded_registry_t &output, size_t source_index) {
+  std::vector<std::pair<std::string, std::string>> defines;
+  std::string code;
+  preprocessor_t preprocessor;
+  auto stripped = strip_comments(source);
+  for (size_t begin = 0, end = 0; begin < stripped.size(); begin = end + 1) {
+    end = stripped.find('\n', begin);
+    if (end == std::string::npos)
+      end = stripped.size();
+    auto line = std::string_view(stripped).substr(begin, end - begin);
+    if (!preprocessor.process(line, defines) && preprocessor.is_active())
+      (code += line) += '\n';
+  }
+
+  // The declarations share one text, the undecoded helper entities keep a part of it each.
+  std::string declaration_text;
+  std::vector<std::pair<size_t, size_t>> declarations;
+  auto add_declaration = [&declaration_text, &declarations](std::string const &declaration) {
+    declarations.emplace_back(declaration_text.size(), declaration.size());
+    declaration_text += declaration;
+  };
+  std::string current;
+  size_t braces = 0, parentheses = 0, extern_blocks = 0;
+  for (char character : code) {
+    if (!braces && !parentheses)
+      if (character == ';') {
+        add_declaration(normalize(current));
+        current.clear();
+        continue;
+      } else if (character == '{' && trim(current) == "extern \"C\""sv) {
+        current.clear();
+        ++extern_blocks;
+        continue;
+      } else if (character == '}' && extern_blocks && trim(current).empty()) {
+        current.clear();
+        --extern_blocks;
+        continue;
+      }
+    current += character;
+    if (character == '{')
+      ++braces;
+    else if (character == '}' && braces && !--braces)
+      if (auto head = trim(std::string_view(current).substr(0, current.find('{')));
+          !head.empty() && head.back() == ')') {
+        // A function definition: keep its signature only.
+        add_declaration(normalize(head));
+        current.clear();
+      }
+    if (character == '(')
+      ++parentheses;
+    else if (character == ')' && parentheses && !--parentheses && !braces)
+      if (auto name = read_identifier(trim(current));
+          name.size() > 7 && name.substr(name.size() - 7) == "_HANDLE"sv) {
+        // Handle definitions are collected by 'load_handle_list'.
+        current.clear();
+      }
+  }
+
+  std::vector<type_t> structures;
+  std::vector<identifier_t> structure_names;
+  std::vector<variable_t> typedefs;
+  std::vector<enum_t> enumerations;
+  std::vector<function_t> functions;
+  transparent_map<enum_t> flag_bits;
+  transparent_set typedef_names; // Of the first 'named_typedefs' of 'typedefs'.
+  size_t named_typedefs = 0;
+  auto text = std::make_shared<std::string const>(std::move(declaration_text));
+  auto slice_of = [&text](std::string_view part) {
+    return source_slice_t{ text, size_t(part.data() - text->data()), part.size() };
+  };
+  for (auto [offset, size] : declarations) {
+    auto declaration = std::string_view(*text).substr(offset, size);
+    bool is_typedef = declaration.substr(0, 8) == "typedef "sv;
+    if (is_typedef)
+      declaration.remove_prefix(8);
+    for (auto qualifier : { "static "sv, "inline "sv, "extern "sv })
+      if (declaration.substr(0, qualifier.size()) == qualifier)
+        declaration.remove_prefix(qualifier.size());
+
+    auto kind = read_identifier(declaration);
+    if (auto body_begin = declaration.find('{');
+        (kind == "struct"sv || kind == "union"sv || kind == "enum"sv)
+        && body_begin != std::string_view::npos) {
+      auto body_end = find_closing(declaration, body_begin, '{', '}');
+      if (body_end == std::string_view::npos) {
+        detail::message() << "Warning: Ignore an unterminated " << kind << " declaration.\n";
+        continue;
+      }
+      auto body = declaration.substr(body_begin + 1, body_end - body_begin - 1);
+      auto head = trim(declaration.substr(kind.size(), body_begin - kind.size()));
+      auto underlying = std::string_view{};
+      if (auto colon = head.find(':'); colon != std::string_view::npos) {
+        underlying = trim(head.substr(colon + 1));
+        head = trim(head.substr(0, colon));
+      }
+      auto alias = is_typedef ? last_identifier(declaration.substr(body_end + 1)) : ""sv;
+      auto name = std::string(head.empty() ? alias : head);
+      if (name.empty()) {
+        detail::message() << "Warning: Ignore an anonymous " << kind << ".\n";
+        continue;
+      }
+
+      if (kind == "struct"sv || kind == "union"sv) {
+        type::structure structure;
+        structure.is_union = kind == "union"sv;
+        // Nested declarations are reported right away, so those are never left undecoded.
+        if (tag == type_tag::helper && body.find('{') == std::string_view::npos)
+          structure.members = bind_current_run([body = slice_of(body), name] {
+            return load_struct_body(body.view(), name);
+          });
+        else
+          structure.members = load_struct_body(body, name);
+        structure_names.emplace_back(name);
+        structures.emplace_back(type_t{ std::move(structure), tag });
+      } else if (kind == "enum"sv) {
+        enum_t enumeration;
+        enumeration.name = name;
+        if (!underlying.empty())
+          enumeration.state.type = std::string(underlying);
+        for (auto enumerator : split(body, ','))
+          if (auto equals = enumerator.find('='); equals != std::string_view::npos)
+            append_enumerator(enumeration, std::string(trim(enumerator.substr(0, equals))),
+                              std::string(trim(enumerator.substr(equals + 1))));
+        enumerations.emplace_back(std::move(enumeration));
+      } else {
+        detail::message() << "Warning: Ignore a compound of an unknown kind: '" << kind << "'.\n";
+        continue;
+      }
+      if (!alias.empty())
+        typedefs.emplace_back(std::string(alias), std::string(kind) + " " + name);
+    } else if (auto pointer = declaration.find("(*");
+               is_typedef && pointer != std::string_view::npos) {
+      auto name_end = declaration.find(')', pointer);
+      if (name_end == std::string_view::npos) {
+        detail::message() << "Warning: Ignore a malformed function pointer: '" << declaration
+                          << "'.\n";
+        continue;
+      }
+      typedefs.emplace_back(
+        std::string(trim(declaration.substr(pointer + 2, name_end - pointer - 2))),
+        std::string(trim(declaration.substr(0, pointer))) + "(*)"
+          + std::string(trim(declaration.substr(name_end + 1))));
+    } else if (is_typedef) {
+      auto args_begin = declaration.find('[');
+      auto args = args_begin == std::string_view::npos ? ""sv : declaration.substr(args_begin);
+      auto head = trim(declaration.substr(0, args_begin));
+      if (auto name = last_identifier(head); !name.empty())
+        typedefs.emplace_back(std::string(name),
+                              std::string(trim(head.substr(0, head.size() - name.size())))
+                                + std::string(args));
+    } else if (auto equals = declaration.find('=');
+               kind == "const"sv && equals != std::string_view::npos) {
+      // A 64-bit flag bit: 'static const VkAccessFlagBits2 VK_ACCESS_2_NONE = 0ULL'.
+      auto head = trim(declaration.substr(0, equals));
+      auto name = last_identifier(head);
+      auto type = trim(head.substr(kind.size(), head.size() - kind.size() - name.size()));
+      for (; named_typedefs < typedefs.size(); ++named_typedefs)
+        typedef_names.emplace(typedefs[named_typedefs].name);
+      if (name.empty()
+          || !append_flag_bit(flag_bits, typedef_names, type, std::string(name),
+                              std::string(trim(declaration.substr(equals + 1)))))
+        detail::message() << "Ignore an unknown file entry '" << declaration << "'.\n";
+    } else if (auto parameters_begin = declaration.find('(');
+               parameters_begin != std::string_view::npos) {
+      auto parameters_end = find_closing(declaration, parameters_begin, '(', ')');
+      auto head = trim(declaration.substr(0, parameters_begin));
+      auto name = last_identifier(head);
+      if (parameters_end == std::string_view::npos || name.empty()) {
+        detail::message() << "Warning: Ignore a malformed function: '" << declaration << "'.\n";
+        continue;
+      }
+      function_t function;
+      function.name = name;
+      function.state.return_type = std::string(trim(head.substr(0, head.size() - name.size())));
+      auto parameters =
+        declaration.substr(parameters_begin + 1, parameters_end - parameters_begin - 1);
+      if (tag == type_tag::helper)
+        function.state.parameters = bind_current_run([parameters = slice_of(parameters)] {
+          return load_parameters(parameters.view());
+        });
+      else
+        function.state.parameters = load_parameters(parameters);
+      if (function.state.return_type)
+        functions.emplace_back(std::move(function));
+    } else if (kind != "struct"sv && kind != "union"sv && kind != "enum"sv && !declaration.empty())
+      detail::message() << "Ignore an unknown file entry '" << declaration << "'.\n";
+  }
+
+  // Mirror the order in which doxygen lists the same entities: struct compounds first, then
+  // file members grouped by section.
+  size_t position = 0;
+  for (size_t i = 0; i < structures.size(); ++i)
+    output.add({ source_index, position++ }, std::move(structure_names[i]),
+               std::move(structures[i]));
+  for (auto &define : defines)
+    output.add({ source_index, position++ }, std::move(define.first),
+               type_t{ type::macro{ std::move(define.second) }, tag });
+  for (auto &type_def : typedefs)
+    if (auto type_data = make_typedef(type_def, tag); type_data) {
+      apply_flag_bits(flag_bits, type_def.name, *type_data);
+      output.add({ source_index, position++ }, std::move(type_def.name), std::move(*type_data));
+    }
+  for (auto &enumeration : enumerations)
+    output.add({ source_index, position++ }, std::move(enumeration.name),
+               type_t{ type::enumeration{ std::move(enumeration.state) }, tag });
+  for (auto &function : functions)
+    output.add({ source_index, position++ }, std::move(function.name),
+               type_t{ type::function{ std::move(function.state) }, tag });
+}
+void vkma_xml::detail::api_t::load_header(std::string_view source, type_tag tag) {
+  sharded_registry_t output(1);
+  load_header(source, tag, output, 0);
+  output.merge(*this);
+}
+
+void vkma_xml::detail::api_t::load_headers(std::vector<std::filesystem::path> const &files,
+                                           type_tag tag) {
+  // Files are parsed concurrently, the registry sees them in the order they are listed.
+  auto selected = files;
+  if (shard)
+    shard->select(selected);
+  sharded_registry_t output;
+  task_graph_t graph;
+  std::vector<message_buffer_t> messages(selected.size());
+  for (size_t i = 0; i < selected.size(); ++i)
+    graph.add("read_header", [&selected, &output, &messages, tag, i] {
+      message_buffer_t::capture_t capture(messages[i]);
+      if (auto source = load_text(selected[i]); source) {
+        trace_span_t span("load_header");
+        if (span)
+          span.arg("file", selected[i].string()).arg("bytes", source->size());
+        load_header(*source, tag, output, i);
+      }
+    });
+  graph.run(selected.size());
+  for (auto &buffer : messages)
+    buffer.flush();
+  output.merge(*this);
+
+  if (!shard || shard->is_last())
+    for (auto const &handle : load_handle_list(files))
+      add(identifier_t(handle.first), type_t{ type::handle{ handle.second }, tag });
+}
@@ -0,0 +1,140 @@
+﻿// Copyright (c) 2021 Cvelth <cvelth.mail@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#include <algorithm>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "async.hpp"
+#include "generator.hpp"
+
+static std::optional<std::string> read_file(std::filesystem::path const &file) {
+  if (std::ifstream stream(file, std::fstream::ate); stream) {
+    size_t source_size = stream.tellg();
+    std::string source(source_size, '\0');
+    stream.seekg(0);
+    stream.read(source.data(), source_size);
+    return source;
+  }
+  return std::nullopt;
+}
+std::optional<std::string> vkma_xml::detail::load_text(std::filesystem::path const &file) {
+  if (auto source = read_file(file); source)
+    return source;
+  else
+    detail::message() << "Error: Ignore '" << std::filesystem::absolute(file)
+                      << "'. Unable to read it. Make sure it exists and is accessible.";
+  return std::nullopt;
+}
+
+// A worker never waits for the consumer, as the executor may run it on the consumer thread: it
+// returns once the window is full, and 'next' offers another one once half of it is consumed.
+struct vkma_xml::detail::read_ahead_t::state_t {
+  std::vector<std::filesystem::path> const &files;
+  std::vector<std::optional<std::string>> buffers;
+  std::vector<bool> ready;
+  size_t claimed = 0;
+  size_t consumed = 0;
+  size_t window;
+  size_t thread_count;
+  size_t offered = 0; // Workers given to the executor that have not returned yet.
+  size_t active = 0;  // The ones among them that started before the reader was destroyed.
+  bool stopping = false;
+  std::mutex mutex;
+  std::condition_variable ready_condition;
+  std::condition_variable left_condition;
+  run_context_t const *run = current_run;
+
+  state_t(std::vector<std::filesystem::path> const &files, size_t thread_count, size_t window)
+    : files(files), buffers(files.size()), ready(files.size()),
+      window(std::max<size_t>(window, 1)), thread_count(thread_count) {}
+
+  // Once the call is stopped, the rest is handed over unread.
+  std::optional<std::string> read(size_t index) const {
+    return is_stop_requested() ? std::nullopt : read_file(files[index]);
+  }
+  static void offer(std::shared_ptr<state_t> const &state) {
+    {
+      std::lock_guard lock(state->mutex);
+      if (state->stopping || state->offered >= state->thread_count
+          || state->claimed >= state->files.size()
+          || state->claimed - state->consumed > state->window / 2)
+        return;
+      ++state->offered;
+    }
+    execute([state] { state->work(); });
+  }
+  void work() {
+    {
+      std::lock_guard lock(mutex);
+      if (stopping) {
+        --offered; // Started late: 'files' may be gone already.
+        return;
+      }
+      ++active;
+    }
+    {
+      run_scope_t scope(run);
+      while (true) {
+        size_t index;
+        {
+          std::lock_guard lock(mutex);
+          if (stopping || claimed >= files.size() || claimed >= consumed + window)
+            break;
+          index = claimed++;
+        }
+        auto source = read(index);
+        {
+          std::lock_guard lock(mutex);
+          buffers[index] = std::move(source);
+          ready[index] = true;
+        }
+        ready_condition.notify_all();
+      }
+    }
+    std::lock_guard lock(mutex);
+    --offered;
+    if (--active == 0)
+      left_condition.notify_all();
+  }
+};
+
+vkma_xml::detail::read_ahead_t::read_ahead_t(std::vector<std::filesystem::path> const &files,
+                                             size_t thread_count, size_t window)
+  : state(std::make_shared<state_t>(files, thread_count, window)) {
+  for (size_t i = 0; i < thread_count; ++i)
+    state_t::offer(state);
+}
+vkma_xml::detail::read_ahead_t::~read_ahead_t() {
+  std::unique_lock lock(state->mutex);
+  state->stopping = true;
+  state->left_condition.wait(lock, [this] { return state->active == 0; });
+}
+std::optional<std::string> vkma_xml::detail::read_ahead_t::next() {
+  std::optional<std::string> output;
+  {
+    std::unique_lock lock(state->mutex);
+    auto index = state->consumed;
+    if (state->claimed == index) {
+      // No worker got to it yet, the executor may start them late or never.
+      ++state->claimed;
+      lock.unlock();
+      output = state->read(index);
+      lock.lock();
+    } else {
+      state->ready_condition.wait(lock, [this, index] { return state->ready[index]; });
+      output = std::move(state->buffers[index]);
+      state->buffers[index].reset();
+    }
+    ++state->consumed;
+  }
+  state_t::offer(state);
+  return output;
+}
+size_t vkma_xml::detail::read_ahead_t::size() const { return state->files.size(); }
@@ -0,0 +1,140 @@
+﻿// Copyright (c) 2021 Cvelth <cvelth.mail@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#include <utility>
+
+#include "query.hpp"
+
+vkma_xml::query_t::query_t(detail::api_t const &api)
+  : api(api), dependency_lists(api.registry.size()), user_lists(api.registry.size()) {
+  struct dependency_visitor {
+    detail::type_registry const &registry_ref;
+    detail::identifier_t const &name_ref;
+    entry_list_t &output_ref;
+    // 'added[index] == stamp' once the entry with that index is in 'output_ref'.
+    std::vector<size_t> &added_ref;
+    size_t stamp;
+    // Undecoded helper members and parameters stay that way.
+    bool is_helper;
+
+    inline void add(std::string_view name) {
+      if (auto iterator = registry_ref.find(name); iterator != registry_ref.end())
+        if (auto &added = added_ref[iterator->second.index]; added != stamp) {
+          added = stamp;
+          output_ref.emplace_back(&*iterator);
+        }
+    }
+
+    inline void operator()(detail::type::undefined const &) {}
+    inline void operator()(detail::type::structure const &structure) {
+      if (is_helper)
+        return;
+      for (auto const &member : *structure.members) {
+        add(member.type.name());
+        if (member.array)
+          add(*member.array);
+      }
+    }
+    inline void operator()(detail::type::handle const &handle) {
+      if (handle.parent)
+        add(*handle.parent);
+    }
+    inline void operator()(detail::type::macro const &) {}
+    inline void operator()(detail::type::enumeration const &enumeration) {
+      if (enumeration.type)
+        add(enumeration.type->name());
+    }
+    inline void operator()(detail::type::function const &function) {
+      add(function.return_type.name());
+      if (!is_helper)
+        for (auto const &parameter : *function.parameters)
+          add(parameter.type.name());
+    }
+    inline void operator()(detail::type::function_pointer const &function_pointer) {
+      add(function_pointer.return_type.name());
+      for (auto const &parameter : function_pointer.parameters)
+        add(parameter.type.name());
+    }
+    inline void operator()(detail::type::alias const &alias) {
+      add(alias.real_type.name());
+      // Same as the flag bits the generator attaches to bitmasks.
+      if (alias.real_type.name() == "VkFlags" || alias.real_type.name() == "VkFlags64")
+        if (auto bits = detail::flag_bits_of(name_ref); bits)
+          add(*bits);
+    }
+    inline void operator()(detail::type::base const &) {}
+  };
+
+  std::vector<size_t> added(api.registry.size());
+  for (auto const *entry : api.registry.entries()) {
+    kinds[static_cast<size_t>(kind_of(entry->second)) * tag_count
+          + static_cast<size_t>(entry->second.tag)]
+      .emplace_back(entry);
+
+    auto &dependencies = dependency_lists[entry->second.index];
+    std::visit(dependency_visitor{ api.registry, entry->first, dependencies, added,
+                                   entry->second.index + 1,
+                                   entry->second.tag == detail::type_tag::helper },
+               entry->second.state);
+    for (auto const *dependency : dependencies)
+      user_lists[dependency->second.index].emplace_back(entry);
+  }
+}
+
+vkma_xml::query_t::entry_t const *vkma_xml::query_t::find(std::string_view name) const {
+  if (auto iterator = api.registry.find(name); iterator != api.registry.end())
+    return &*iterator;
+  else
+    return nullptr;
+}
+vkma_xml::query_t::entry_list_t const &vkma_xml::query_t::of_kind(type_kind kind,
+                                                                  detail::type_tag tag) const {
+  return kinds[static_cast<size_t>(kind) * tag_count + static_cast<size_t>(tag)];
+}
+vkma_xml::query_t::entry_list_t const &
+vkma_xml::query_t::dependencies(std::string_view name) const {
+  if (auto const *entry = find(name); entry)
+    return dependency_lists[entry->second.index];
+  else
+    return empty_list;
+}
+vkma_xml::query_t::entry_list_t const &vkma_xml::query_t::users(std::string_view name) const {
+  if (auto const *entry = find(name); entry)
+    return user_lists[entry->second.index];
+  else
+    return empty_list;
+}
+
+vkma_xml::query_t::entry_list_t vkma_xml::query_t::closure(entry_list_t const &roots) const {
+  entry_list_t output;
+  std::vector<bool> visited(dependency_lists.size());
+  // Depth first, with an explicit stack: dependency chains can be as long as the api.
+  std::vector<std::pair<entry_t const *, size_t>> stack; // { entry, next dependency }
+  for (auto const *root : roots) {
+    if (visited[root->second.index])
+      continue;
+    visited[root->second.index] = true;
+    stack.emplace_back(root, 0);
+    while (!stack.empty()) {
+      auto &[entry, next] = stack.back();
+      if (auto const &dependencies = dependency_lists[entry->second.index];
+          next < dependencies.size()) {
+        auto const *dependency = dependencies[next++];
+        if (!visited[dependency->second.index]) {
+          visited[dependency->second.index] = true;
+          stack.emplace_back(dependency, 0);
+        }
+      } else {
+        output.emplace_back(entry);
+        stack.pop_back();
+      }
+    }
+  }
+  return output;
+}
+vkma_xml::query_t::entry_list_t vkma_xml::query_t::closure(std::string_view name) const {
+  if (auto const *entry = find(name); entry)
+    return closure(entry_list_t{ entry });
+  else
+    return {};
+}
@@ -0,0 +1,326 @@
+﻿// Copyright (c) 2021 Cvelth <cvelth.mail@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <string>
+
+#include "async.hpp"
+#include "shard.hpp"
+#include "task_graph.hpp"
+#include "trace.hpp"
+
+using namespace std::literals;
+
+namespace {
+  namespace detail = vkma_xml::detail;
+
+  // Saved shards start with this line. Bump the version with every change to the layout.
+  constexpr std::string_view shard_header = "vkma_xml shard 2\n"sv;
+
+  // Every field is a netstring, "<size>:<bytes>", so that nothing needs escaping.
+  struct writer_t {
+    std::string output;
+
+    inline writer_t &add(std::string_view value) {
+      (output += std::to_string(value.size())) += ':';
+      output += value;
+      return *this;
+    }
+    inline writer_t &add(std::uint64_t number) {
+      return add(std::string_view(std::to_string(number)));
+    }
+    inline writer_t &add_optional(std::optional<std::string> const &value) {
+      add(std::uint64_t(value.has_value()));
+      return value ? add(*value) : *this;
+    }
+    inline writer_t &add(std::vector<detail::variable_t> const &variables) {
+      add(variables.size());
+      for (auto const &variable : variables)
+        add(variable.name).add(variable.type.spelling()).add_optional(variable.array);
+      return *this;
+    }
+    inline writer_t &add(std::vector<detail::constant_t> const &constants) {
+      add(constants.size());
+      for (auto const &constant : constants) {
+        add(constant.name).add(constant.value).add(std::uint64_t(constant.number.has_value()));
+        if (constant.number)
+          add(std::string_view(std::to_string(*constant.number)));
+      }
+      return *this;
+    }
+    // Undecoded values are decoded to be saved, but stay undecoded once loaded.
+    inline writer_t &add(detail::lazy_t<std::vector<detail::variable_t>> const &variables) {
+      return add(std::uint64_t(variables.is_decoded())).add(*variables);
+    }
+  };
+
+  // Reads what 'writer_t' wrote. Once a field is missing or malformed, every later one reads as
+  // empty and 'failed' is set.
+  struct reader_t {
+    std::string_view input;
+    bool failed = false;
+
+    std::string_view string() {
+      size_t size = 0;
+      auto [end, error] = std::from_chars(input.data(), input.data() + input.size(), size);
+      size_t offset = end - input.data();
+      if (failed || error != std::errc{} || offset >= input.size() || input[offset] != ':'
+          || input.size() - offset - 1 < size) {
+        failed = true;
+        return {};
+      }
+      auto output = input.substr(offset + 1, size);
+      input.remove_prefix(offset + 1 + size);
+      return output;
+    }
+    template <typename number_t>
+    number_t number() {
+      auto value = string();
+      number_t output = 0;
+      if (auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), output);
+          error != std::errc{} || end != value.data() + value.size())
+        failed = true;
+      return output;
+    }
+    bool flag() { return number<std::uint64_t>() != 0; }
+    std::optional<std::string> optional_string() {
+      if (flag())
+        return std::string(string());
+      return std::nullopt;
+    }
+    // A size is never larger than what is left to read, so a corrupt one cannot allocate much.
+    size_t size() {
+      auto output = number<size_t>();
+      if (output > input.size()) {
+        failed = true;
+        return 0;
+      }
+      return output;
+    }
+    std::vector<detail::variable_t> variables() {
+      std::vector<detail::variable_t> output;
+      auto count = size();
+      output.reserve(count);
+      for (size_t i = 0; i < count && !failed; ++i) {
+        auto name = string();
+        auto type = string();
+        output.emplace_back(std::string(name), std::string(type), optional_string());
+      }
+      return output;
+    }
+    std::vector<detail::constant_t> constants() {
+      std::vector<detail::constant_t> output;
+      auto count = size();
+      output.reserve(count);
+      for (size_t i = 0; i < count && !failed; ++i) {
+        auto name = string();
+        auto value = string();
+        auto number = flag() ? std::optional(this->number<std::int64_t>()) : std::nullopt;
+        output.emplace_back(std::string(name), std::string(value), number);
+      }
+      return output;
+    }
+    detail::lazy_t<std::vector<detail::variable_t>> lazy_variables() {
+      bool is_decoded = flag();
+      auto output = variables();
+      if (is_decoded)
+        return output;
+      return [output = std::move(output)] { return output; };
+    }
+
+    detail::type_t::state_t state(size_t index) {
+      switch (index) {
+      case 0: return detail::type::undefined{};
+      case 1: {
+        bool is_union = flag();
+        return detail::type::structure{ lazy_variables(), is_union };
+      }
+      case 2: {
+        bool dispatchable = flag();
+        return detail::type::handle{ dispatchable, optional_string() };
+      }
+      case 3: return detail::type::macro{ std::string(string()) };
+      case 4: {
+        detail::type::enumeration enumeration;
+        if (auto type = optional_string(); type)
+          enumeration.type = detail::decorated_typename_t(std::move(*type));
+        enumeration.values = constants();
+        enumeration.aliases = constants();
+        return enumeration;
+      }
+      case 5: {
+        auto return_type = std::string(string());
+        return detail::type::function{ std::move(return_type), lazy_variables() };
+      }
+      case 6: {
+        auto return_type = std::string(string());
+        return detail::type::function_pointer{ std::move(return_type), variables() };
+      }
+      case 7: return detail::type::alias{ std::string(string()) };
+      case 8: return detail::type::base{};
+      default: failed = true; return detail::type::undefined{};
+      }
+    }
+  };
+} // namespace
+
+bool vkma_xml::save_shard(detail::api_t const &api, std::filesystem::path const &path) {
+  struct save_visitor {
+    writer_t &writer_ref;
+
+    inline void operator()(detail::type::undefined const &) {}
+    inline void operator()(detail::type::structure const &structure) {
+      writer_ref.add(std::uint64_t(structure.is_union)).add(structure.members);
+    }
+    inline void operator()(detail::type::handle const &handle) {
+      writer_ref.add(std::uint64_t(handle.dispatchable)).add_optional(handle.parent);
+    }
+    inline void operator()(detail::type::macro const &macro) { writer_ref.add(macro.value); }
+    inline void operator()(detail::type::enumeration const &enumeration) {
+      writer_ref.add(std::uint64_t(enumeration.type.has_value()));
+      if (enumeration.type)
+        writer_ref.add(enumeration.type->spelling());
+      writer_ref.add(enumeration.values).add(enumeration.aliases);
+    }
+    inline void operator()(detail::type::function const &function) {
+      writer_ref.add(function.return_type.spelling()).add(function.parameters);
+    }
+    inline void operator()(detail::type::function_pointer const &function_pointer) {
+      writer_ref.add(function_pointer.return_type.spelling()).add(function_pointer.parameters);
+    }
+    inline void operator()(detail::type::alias const &alias) {
+      writer_ref.add(alias.real_type.spelling());
+    }
+    inline void operator()(detail::type::base const &) {}
+  };
+
+  detail::trace_span_t span("save_shard");
+  if (!api.shard)
+    return false;
+  writer_t writer;
+  writer.output = shard_header;
+  writer.add(api.shard->index).add(api.shard->count).add(api.input_fingerprint);
+  writer.add(api.partial_journals.size());
+  for (auto const &journal : api.partial_journals) {
+    // A 'get' of a name the journal has already seen does nothing once replayed.
+    std::vector<detail::registry_journal_t::record_t const *> records;
+    detail::transparent_set seen;
+    for (auto const &record : journal.calls())
+      if (seen.emplace(record.first).second || record.second)
+        records.emplace_back(&record);
+
+    writer.add(records.size());
+    for (auto const *record : records) {
+      writer.add(record->first).add(std::uint64_t(record->second.has_value()));
+      if (auto const &type_data = record->second; type_data) {
+        writer.add(std::uint64_t(type_data->tag == detail::type_tag::core))
+          .add(type_data->state.index());
+        std::visit(save_visitor{ writer }, type_data->state);
+      }
+    }
+  }
+  if (span)
+    span.arg("bytes", writer.output.size());
+
+  std::ofstream stream(path, std::ios::binary);
+  return stream && stream.write(writer.output.data(), writer.output.size());
+}
+
+std::optional<vkma_xml::detail::shard_file_t>
+vkma_xml::detail::load_shard(std::filesystem::path const &path) {
+  trace_span_t span("load_shard");
+  auto source = load_text(path);
+  if (!source)
+    return std::nullopt;
+  if (span)
+    span.arg("bytes", source->size());
+
+  reader_t reader{ *source };
+  if (!reader.input.starts_with(shard_header)) {
+    message() << "Error: " << std::filesystem::absolute(path)
+              << " is not a shard of this version.\n";
+    return std::nullopt;
+  }
+  reader.input.remove_prefix(shard_header.size());
+
+  shard_file_t output;
+  output.shard.index = reader.number<size_t>();
+  output.shard.count = reader.number<size_t>();
+  output.input_fingerprint = reader.number<std::uint64_t>();
+  output.journals.resize(reader.size());
+  for (auto &journal : output.journals)
+    for (size_t i = reader.size(); i > 0 && !reader.failed; --i) {
+      auto name = identifier_t(reader.string());
+      if (reader.flag()) {
+        auto tag = reader.flag() ? type_tag::core : type_tag::helper;
+        auto state = reader.state(reader.number<size_t>());
+        journal.add(std::move(name), type_t{ std::move(state), tag });
+      } else
+        journal.get(std::move(name));
+    }
+  if (reader.failed || !reader.input.empty() || output.shard.index >= output.shard.count) {
+    message() << "Error: " << std::filesystem::absolute(path) << " is corrupt.\n";
+    return std::nullopt;
+  }
+  return output;
+}
+
+std::optional<vkma_xml::detail::api_t>
+vkma_xml::merge_shards(std::vector<std::filesystem::path> const &paths) {
+  detail::trace_span_t span("merge_shards");
+  auto start_time = std::chrono::high_resolution_clock::now();
+
+  // Shards are decoded concurrently, the registry takes them in order.
+  std::vector<std::optional<detail::shard_file_t>> shards(paths.size());
+  detail::task_graph_t graph;
+  for (size_t i = 0; i < paths.size(); ++i)
+    graph.add("load_shard", [&paths, &shards, i] { shards[i] = detail::load_shard(paths[i]); });
+  if (!graph.run() || paths.empty())
+    return std::nullopt;
+  for (auto const &shard : shards)
+    if (!shard)
+      return std::nullopt;
+
+  // By part, whatever the order of 'paths'. Each part has to be there once, from the same inputs.
+  std::vector<size_t> order(paths.size());
+  for (size_t i = 0; i < order.size(); ++i)
+    order[i] = i;
+  std::stable_sort(order.begin(), order.end(), [&shards](size_t left, size_t right) {
+    return shards[left]->shard.index < shards[right]->shard.index;
+  });
+  auto const &first = *shards[order.front()];
+  for (size_t position = 0; position < order.size(); ++position) {
+    auto const &path = paths[order[position]];
+    auto const &shard = *shards[order[position]];
+    if (shard.shard.count != paths.size()) {
+      detail::message() << "Error: " << std::filesystem::absolute(path) << " is a part out of "
+                        << shard.shard.count << ", not out of " << paths.size() << ".\n";
+      return std::nullopt;
+    } else if (position && shard.shard.index == shards[order[position - 1]]->shard.index) {
+      detail::message() << "Error: " << std::filesystem::absolute(path) << " and "
+                        << std::filesystem::absolute(paths[order[position - 1]])
+                        << " are both part " << shard.shard.index << ".\n";
+      return std::nullopt;
+    } else if (shard.shard.index != position) {
+      detail::message() << "Error: Part " << position << " out of " << paths.size()
+                        << " is missing.\n";
+      return std::nullopt;
+    } else if (shard.input_fingerprint != first.input_fingerprint
+               || shard.journals.size() != first.journals.size()) {
+      detail::message() << "Error: " << std::filesystem::absolute(path)
+                        << " was parsed from different inputs than "
+                        << std::filesystem::absolute(paths[order.front()]) << ".\n";
+      return std::nullopt;
+    }
+  }
+
+  // The inputs one by one, every one of them shard by shard: the order of a single 'parse'.
+  detail::api_t output;
+  for (size_t input = 0; input < first.journals.size(); ++input)
+    for (size_t index : order)
+      shards[index]->journals[input].replay(output.registry);
+  detail::finish_parsing(output, start_time);
+  return output;
+}
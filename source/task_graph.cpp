@@ -0,0 +1,159 @@
+﻿// Copyright (c) 2021 Cvelth <cvelth.mail@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+#include "async.hpp"
+#include "task_graph.hpp"
+#include "trace.hpp"
+
+vkma_xml::detail::task_graph_t::task_id
+vkma_xml::detail::task_graph_t::add(std::string_view name, std::function<void()> &&task,
+                                    std::vector<task_id> const &dependencies) {
+  task_id id = nodes.size();
+  for (auto dependency : dependencies)
+    nodes[dependency].dependents.emplace_back(id);
+  nodes.emplace_back(node_t{ std::string(name), std::move(task), {}, dependencies.size() });
+  return id;
+}
+
+bool vkma_xml::detail::task_graph_t::run(size_t thread_count) {
+  if (nodes.empty())
+    return !is_stop_requested();
+  thread_count = std::clamp<size_t>(thread_count, 1, nodes.size());
+
+  struct worker_t {
+    std::mutex mutex;
+    std::deque<task_id> ready;
+  };
+  auto const *context = current_run;
+  auto workers = std::make_unique<worker_t[]>(thread_count);
+  auto pending = std::make_unique<std::atomic<size_t>[]>(nodes.size());
+  std::atomic<size_t> ready_count = 0;
+  std::atomic<size_t> remaining = nodes.size();
+  std::atomic<bool> cancelled = false;
+  std::atomic<bool> skipped = false;
+  std::atomic<size_t> done = 0;
+  std::exception_ptr failure;
+  std::mutex mutex; // Guards 'failure' and the sleeping workers.
+  std::condition_variable wake;
+
+  auto push = [&](size_t worker, task_id id) {
+    {
+      std::lock_guard lock(workers[worker].mutex);
+      workers[worker].ready.emplace_back(id);
+    }
+    ++ready_count;
+    { std::lock_guard lock(mutex); }
+    wake.notify_one();
+  };
+  auto pop = [&](size_t worker) -> std::optional<task_id> {
+    for (size_t i = 0; i < thread_count; ++i) {
+      auto &victim = workers[(worker + i) % thread_count];
+      std::lock_guard lock(victim.mutex);
+      if (!victim.ready.empty()) {
+        task_id id;
+        if (i == 0) {
+          id = victim.ready.back();
+          victim.ready.pop_back();
+        } else {
+          id = victim.ready.front();
+          victim.ready.pop_front();
+        }
+        --ready_count;
+        return id;
+      }
+    }
+    return std::nullopt;
+  };
+  auto work = [&](size_t worker) {
+    while (remaining > 0)
+      if (auto id = pop(worker); id) {
+        auto &node = nodes[*id];
+        if (!cancelled && is_stop_requested())
+          skipped = cancelled = true;
+        if (!cancelled) {
+          trace_span_t span(node.name);
+          try {
+            node.task();
+          } catch (...) {
+            std::lock_guard lock(mutex);
+            if (!failure)
+              failure = std::current_exception();
+            cancelled = true;
+          }
+          if (context && context->reports_progress && context->options.on_progress) {
+            std::lock_guard lock(context->callback_mutex);
+            context->options.on_progress(node.name, ++done, nodes.size());
+          }
+        }
+        for (auto dependent : node.dependents)
+          if (--pending[dependent] == 0)
+            push(worker, dependent);
+        if (--remaining == 0) {
+          { std::lock_guard lock(mutex); }
+          wake.notify_all();
+        }
+      } else {
+        std::unique_lock lock(mutex);
+        wake.wait(lock, [&] { return ready_count > 0 || remaining == 0; });
+      }
+  };
+
+  for (task_id id = 0, worker = 0; id < nodes.size(); ++id)
+    if ((pending[id] = nodes[id].dependency_count) == 0) {
+      workers[worker].ready.emplace_back(id);
+      ++ready_count;
+      worker = (worker + 1) % thread_count;
+    }
+
+  // Helpers only run while 'run' waits for them: the ones the executor starts late find the
+  // graph closed and return without touching it.
+  struct helpers_t {
+    std::mutex mutex;
+    std::condition_variable left;
+    size_t active = 0;
+    bool is_closed = false;
+  };
+  auto helpers = std::make_shared<helpers_t>();
+  std::optional<run_context_t> nested;
+  if (context)
+    nested.emplace(
+      run_context_t{ context->options, context->callback_mutex, false, context->owner });
+  auto const *helper_context = context ? &*nested : nullptr;
+  for (size_t worker = 1; worker < thread_count; ++worker)
+    execute([helpers, &work, helper_context, worker] {
+      {
+        std::lock_guard lock(helpers->mutex);
+        if (helpers->is_closed)
+          return;
+        ++helpers->active;
+      }
+      auto const *previous = std::exchange(current_run, helper_context);
+      work(worker);
+      current_run = previous;
+      std::lock_guard lock(helpers->mutex);
+      if (--helpers->active == 0)
+        helpers->left.notify_all();
+    });
+  auto const *previous = std::exchange(current_run, helper_context);
+  work(0);
+  current_run = previous;
+  {
+    std::unique_lock lock(helpers->mutex);
+    helpers->is_closed = true;
+    helpers->left.wait(lock, [&] { return helpers->active == 0; });
+  }
+
+  if (failure)
+    std::rethrow_exception(failure);
+  return !skipped;
+}
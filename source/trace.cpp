@@ -0,0 +1,107 @@
+﻿// Copyright (c) 2021 Cvelth <cvelth.mail@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+#include "trace.hpp"
+
+namespace {
+  struct trace_event_t {
+    std::string name;
+    std::string args;
+    std::int64_t begin; // In microseconds since 'enable_trace'.
+    std::int64_t duration;
+    size_t thread;
+  };
+  struct trace_t {
+    std::mutex mutex;
+    std::vector<trace_event_t> events;
+    std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+  };
+  trace_t &trace() {
+    static trace_t instance;
+    return instance;
+  }
+  size_t thread_index() {
+    static std::atomic<size_t> counter = 0;
+    thread_local size_t index = ++counter;
+    return index;
+  }
+  void append_escaped(std::string &output, std::string_view value) {
+    output += '"';
+    for (char character : value)
+      if (character == '"' || character == '\\')
+        (output += '\\') += character;
+      else if (static_cast<unsigned char>(character) < 0x20)
+        output += ' ';
+      else
+        output += character;
+    output += '"';
+  }
+} // namespace
+
+void vkma_xml::enable_trace() {
+  trace();
+  detail::trace_enabled = true;
+}
+bool vkma_xml::save_trace(std::filesystem::path const &path) {
+  std::string output = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  {
+    std::lock_guard lock(trace().mutex);
+    for (auto const &event : trace().events) {
+      if (output.back() != '[')
+        output += ",\n";
+      output += "{\"ph\":\"X\",\"cat\":\"vkma\",\"pid\":1,\"tid\":" + std::to_string(event.thread)
+                + ",\"ts\":" + std::to_string(event.begin)
+                + ",\"dur\":" + std::to_string(event.duration) + ",\"name\":";
+      append_escaped(output, event.name);
+      ((output += ",\"args\":{") += event.args) += "}}";
+    }
+  }
+  output += "]}\n";
+  std::ofstream stream(path, std::ios::binary);
+  return stream && stream.write(output.data(), output.size());
+}
+
+vkma_xml::detail::trace_span_t::trace_span_t(std::string_view name)
+  : active(trace_enabled), name(name) {
+  if (active)
+    start = std::chrono::steady_clock::now();
+}
+vkma_xml::detail::trace_span_t::~trace_span_t() {
+  if (active) {
+    auto finish = std::chrono::steady_clock::now();
+    auto &instance = trace();
+    trace_event_t event{
+      std::string(name), std::move(args),
+      std::chrono::duration_cast<std::chrono::microseconds>(start - instance.origin).count(),
+      std::chrono::duration_cast<std::chrono::microseconds>(finish - start).count(),
+      thread_index()
+    };
+    std::lock_guard lock(instance.mutex);
+    instance.events.emplace_back(std::move(event));
+  }
+}
+vkma_xml::detail::trace_span_t &vkma_xml::detail::trace_span_t::arg(std::string_view key,
+                                                                    std::string_view value) {
+  if (active) {
+    if (!args.empty())
+      args += ',';
+    append_escaped(args, key);
+    args += ':';
+    append_escaped(args, value);
+  }
+  return *this;
+}
+vkma_xml::detail::trace_span_t &vkma_xml::detail::trace_span_t::arg(std::string_view key,
+                                                                    std::uint64_t value) {
+  if (active) {
+    if (!args.empty())
+      args += ',';
+    append_escaped(args, key);
+    (args += ':') += std::to_string(value);
+  }
+  return *this;
+}
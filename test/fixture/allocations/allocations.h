@@ -0,0 +1,5 @@
+// Handles of the allocation-count fixture, doxygen does not see through these macros.
+
+VK_DEFINE_HANDLE(VkbDevice) // parent: none
+VK_DEFINE_NON_DISPATCHABLE_HANDLE(VkbImage) // parent: VkbDevice
+VK_DEFINE_NON_DISPATCHABLE_HANDLE(VkbBuffer) // parent: VkbDevice
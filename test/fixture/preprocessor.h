@@ -0,0 +1,75 @@
+// Copyright (c) 2021 Cvelth <cvelth.mail@gmail.com>
+// SPDX-License-Identifier: MIT
+
+// Conditional declarations 'test_preprocessor' expects to see (or not) after parsing.
+
+#define VMA_VULKAN_VERSION 1001000
+#define VMA_VULKAN_VERSION_COPY VMA_VULKAN_VERSION
+#define VMA_EMPTY_MACRO
+#define VMA_RECURSIVE_MACRO VMA_RECURSIVE_MACRO
+
+#if VMA_VULKAN_VERSION >= 1001000
+typedef struct VmaVersion11 {
+  int value;
+} VmaVersion11;
+#endif
+
+#if VMA_VULKAN_VERSION >= 1002000
+typedef struct VmaVersion12 {
+  int value;
+} VmaVersion12;
+#endif
+
+#if VMA_VULKAN_VERSION_COPY == 1001000 && VMA_VULKAN_VERSION_COPY < 1002000
+typedef struct VmaNestedMacro {
+  int value;
+} VmaNestedMacro;
+#endif
+
+#if defined(VMA_EMPTY_MACRO) && VMA_EMPTY_MACRO
+typedef struct VmaEmptyMacro {
+  int value;
+} VmaEmptyMacro;
+#endif
+
+#if !defined VMA_UNDEFINED_MACRO && !undefinedVMA_EMPTY_MACRO
+typedef struct VmaIdentifierBoundary {
+  int value;
+} VmaIdentifierBoundary;
+#endif
+
+#if defined(VMA_EMPTY_MACRO
+typedef struct VmaUnclosedDefined {
+  int value;
+} VmaUnclosedDefined;
+#endif
+
+#if VMA_RECURSIVE_MACRO
+typedef struct VmaRecursiveMacro {
+  int value;
+} VmaRecursiveMacro;
+#endif
+
+#if defined
+typedef struct VmaTrailingDefined {
+  int value;
+} VmaTrailingDefined;
+#endif
+
+#if (1 << 64) || 1
+typedef struct VmaShiftOutOfRange {
+  int value;
+} VmaShiftOutOfRange;
+#endif
+
+#if ((-9223372036854775807 - 1) / -1) || 1
+typedef struct VmaDivisionOverflow {
+  int value;
+} VmaDivisionOverflow;
+#endif
+
+#if 9223372036854775807 + 1 < 0 && -1 >> 1 == -1 && -(-9223372036854775807 - 1) < 0
+typedef struct VmaWrappingArithmetic {
+  int value;
+} VmaWrappingArithmetic;
+#endif
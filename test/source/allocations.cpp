@@ -0,0 +1,65 @@
+﻿// Copyright (c) 2021 Cvelth <cvelth.mail@gmail.com>
+// SPDX-License-Identifier: MIT
+
+// Counts the heap allocations made while parsing "test/fixture/allocations" and fails once there
+// are more of them per registry entry than the bound recorded below. The xml parser is not
+// counted: the allocations of parsing the same files with 'pugi::xml_document' alone are taken
+// out.
+
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <new>
+#include <vector>
+
+#include "generator.hpp"
+
+// 1334 allocations for 48 entries (28 each) when recorded with libstdc++ 12. The rest leaves
+// room for other standard libraries and for the workers of more cores. Raise it along with a
+// change that has to allocate more, never just to make the test pass.
+static constexpr size_t allocations_per_entry = 40;
+
+static std::atomic<size_t> allocation_count = 0;
+void *operator new(size_t size) {
+  ++allocation_count;
+  if (void *pointer = std::malloc(size ? size : 1); pointer)
+    return pointer;
+  throw std::bad_alloc();
+}
+void operator delete(void *pointer) noexcept { std::free(pointer); }
+void operator delete(void *pointer, size_t) noexcept { std::free(pointer); }
+
+int main() {
+  std::filesystem::path const directory = std::filesystem::path(VMA_XML_TEST_FIXTURE)
+                                          / "allocations";
+  std::vector<std::filesystem::path> const headers = { directory / "allocations.h" };
+
+  std::vector<std::string> sources;
+  for (auto const &entry : std::filesystem::directory_iterator(directory))
+    if (entry.path().extension() == ".xml")
+      if (auto source = vkma_xml::detail::load_text(entry.path()); source)
+        sources.emplace_back(std::move(*source));
+  size_t before = allocation_count;
+  for (auto const &source : sources)
+    pugi::xml_document().load_buffer(source.data(), source.size());
+  size_t xml_allocations = allocation_count - before;
+
+  before = allocation_count;
+  auto api = vkma_xml::parse({ .xml_directory = directory, .header_files = headers });
+  size_t allocations = allocation_count - before - xml_allocations;
+  if (!api || !api->registry.contains("VkbBufferInfo") || !api->registry.contains("VkbImage")) {
+    std::cout << "Error: Unable to parse the 'allocations' fixture.\n";
+    return 1;
+  }
+
+  size_t const allocation_bound = allocations_per_entry * api->registry.size();
+  if (allocations > allocation_bound) {
+    std::cout << "Error: Parsing the fixture took " << allocations
+              << " allocations, the bound is " << allocation_bound << ".\n";
+    return 1;
+  }
+  std::cout << "Success: Parsing the fixture took " << allocations << " allocations (the bound is "
+            << allocation_bound << ").\n";
+  return 0;
+}
@@ -0,0 +1,152 @@
+﻿// Copyright (c) 2021 Cvelth <cvelth.mail@gmail.com>
+// SPDX-License-Identifier: MIT
+
+// Writes tar archives of known members (plain, gzip-compressed, with pax and GNU long names and
+// truncated) and checks what 'archive_t' reads back, then checks that a shuffled archive of
+// "test/fixture/allocations" loads the same registry as the directory itself.
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "generator.hpp"
+#include "zlib.h"
+using namespace std::literals;
+
+using members_t = std::vector<std::pair<std::string, std::string>>;
+
+static std::string const long_name = "docs/xml/" + std::string(120, 'n') + ".xml";
+
+static std::string tar_block(std::string_view name, size_t size, char type) {
+  std::string block(512, '\0');
+  name.substr(0, 100).copy(block.data(), 100);
+  std::snprintf(block.data() + 100, 8, "%07o", 0644u);
+  std::snprintf(block.data() + 124, 12, "%011zo", size);
+  block[156] = type;
+  "ustar\0" "00"sv.copy(block.data() + 257, 8);
+  std::fill_n(block.data() + 148, 8, ' ');
+  unsigned checksum = 0;
+  for (char character : block)
+    checksum += static_cast<unsigned char>(character);
+  std::snprintf(block.data() + 148, 8, "%06o", checksum);
+  return block;
+}
+static void append_member(std::string &output, std::string_view name, std::string_view content,
+                          char type = '0') {
+  output += tar_block(name, content.size(), type);
+  output += content;
+  output.append((512 - content.size() % 512) % 512, '\0');
+}
+static std::string pax_record(std::string_view key, std::string_view value) {
+  auto record = " " + std::string(key) + "=" + std::string(value) + "\n";
+  auto length = record.size() + 1;
+  while (std::to_string(length).size() + record.size() != length)
+    ++length;
+  return std::to_string(length) + record;
+}
+
+// Every member of 'members', the first one behind "./", the second one under a pax long name
+// after a directory entry, the third one under a GNU long name.
+static std::string make_tar(members_t const &members) {
+  std::string output;
+  for (size_t i = 0; i < members.size(); ++i) {
+    auto const &[name, content] = members[i];
+    if (i == 1) {
+      append_member(output, "docs/", "", '5');
+      append_member(output, "PaxHeader", pax_record("path", name), 'x');
+    } else if (i == 2)
+      append_member(output, "././@LongLink", name + '\0', 'L');
+    append_member(output, i ? std::string_view(name).substr(0, 100) : "./" + name, content);
+  }
+  return output.append(1024, '\0');
+}
+
+static bool write_file(std::filesystem::path const &file, std::string_view content,
+                       bool compress = false) {
+  if (compress) {
+    auto output = gzopen(file.string().c_str(), "wb");
+    bool is_written = output && gzwrite(output, content.data(), unsigned(content.size()))
+                                  == int(content.size());
+    return output && gzclose(output) == Z_OK && is_written;
+  }
+  std::ofstream output(file, std::fstream::binary);
+  return static_cast<bool>(output.write(content.data(), content.size()));
+}
+
+static members_t read_archive(std::filesystem::path const &file) {
+  members_t output;
+  if (auto archive = vkma_xml::detail::archive_t::open(file); archive)
+    while (auto member = archive->next())
+      output.emplace_back(std::move(member->name), std::move(member->content));
+  return output;
+}
+
+static std::vector<std::string> registry_of(std::filesystem::path const &xml_directory) {
+  vkma_xml::detail::api_t api;
+  std::vector<std::string> output;
+  if (api.load_doxygen(xml_directory, vkma_xml::detail::type_tag::core))
+    for (auto const *entry : api.registry.entries())
+      output.emplace_back(entry->first);
+  return output;
+}
+
+int main() {
+  auto const directory = std::filesystem::temp_directory_path() / "vkma_xml_archive";
+  std::filesystem::create_directories(directory);
+  int failures = 0;
+  auto check = [&failures](bool condition, std::string_view description) {
+    if (!condition) {
+      std::cout << "Error: " << description << ".\n";
+      ++failures;
+    }
+  };
+
+  members_t const members = { { "docs/index.xml", "<doxygenindex/>" },
+                              { long_name, std::string(1000, 'p') },
+                              { long_name + ".gnu", "" },
+                              { "docs/last.xml", std::string(513, 'l') } };
+  auto const tar = make_tar(members);
+  check(write_file(directory / "plain.tar", tar), "Unable to write 'plain.tar'");
+  check(read_archive(directory / "plain.tar") == members, "'plain.tar' reads back differently");
+  check(write_file(directory / "compressed.tgz", tar, true), "Unable to write 'compressed.tgz'");
+  check(read_archive(directory / "compressed.tgz") == members,
+        "'compressed.tgz' reads back differently");
+
+  // Cut in the middle of the content of the last member.
+  auto const cut = tar.find(members.back().second) + 256;
+  check(write_file(directory / "truncated.tar", std::string_view(tar).substr(0, cut)),
+        "Unable to write 'truncated.tar'");
+  check(read_archive(directory / "truncated.tar") == members_t(members.begin(), members.end() - 1),
+        "'truncated.tar' does not end with the last complete member");
+
+  // The index in the middle, every compound in the reverse of the directory order.
+  auto const fixture = std::filesystem::path(VMA_XML_TEST_FIXTURE) / "allocations";
+  std::vector<std::filesystem::path> files;
+  for (auto const &entry : std::filesystem::directory_iterator(fixture))
+    if (entry.path().extension() == ".xml")
+      files.emplace_back(entry.path());
+  std::sort(files.rbegin(), files.rend());
+  std::erase(files, fixture / "index.xml");
+  files.insert(files.begin() + files.size() / 2, fixture / "index.xml");
+  members_t shuffled;
+  for (auto const &file : files)
+    shuffled.emplace_back("docs/xml/" + file.filename().string(),
+                          vkma_xml::detail::load_text(file).value_or(""));
+  check(write_file(directory / "shuffled.tgz", make_tar(shuffled), true),
+        "Unable to write 'shuffled.tgz'");
+  auto const expected = registry_of(fixture);
+  check(!expected.empty(), "Unable to load the 'allocations' fixture");
+  check(registry_of(directory / "shuffled.tgz") == expected,
+        "'shuffled.tgz' loads a registry different from the one of its directory");
+
+  std::filesystem::remove_all(directory);
+  if (!failures)
+    std::cout << "Success: Every archive reads back as expected.\n";
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,45 @@
+﻿// Copyright (c) 2021 Cvelth <cvelth.mail@gmail.com>
+// SPDX-License-Identifier: MIT
+
+// Parses "test/fixture/preprocessor.h" and checks which of its conditional declarations the
+// header frontend kept. Exits with a non-zero code on the first mismatch.
+
+#include <filesystem>
+#include <iostream>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "generator.hpp"
+using namespace std::literals;
+
+int main() {
+  std::filesystem::path const directory = VMA_XML_TEST_FIXTURE;
+  std::vector<std::filesystem::path> const headers = { directory / "preprocessor.h" };
+  auto api = vkma_xml::parse_headers({ .xml_directory = directory, .header_files = headers });
+  if (!api) {
+    std::cout << "Error: Unable to parse 'preprocessor.h'.\n";
+    return 1;
+  }
+
+  int failures = 0;
+  for (auto [name, expected] : { std::pair{ "VmaVersion11"sv, true },
+                                 std::pair{ "VmaVersion12"sv, false },
+                                 std::pair{ "VmaNestedMacro"sv, true },
+                                 std::pair{ "VmaEmptyMacro"sv, true },
+                                 std::pair{ "VmaIdentifierBoundary"sv, true },
+                                 std::pair{ "VmaUnclosedDefined"sv, false },
+                                 std::pair{ "VmaRecursiveMacro"sv, false },
+                                 std::pair{ "VmaTrailingDefined"sv, false },
+                                 std::pair{ "VmaShiftOutOfRange"sv, false },
+                                 std::pair{ "VmaDivisionOverflow"sv, false },
+                                 std::pair{ "VmaWrappingArithmetic"sv, true } })
+    if (api->registry.contains(name) != expected) {
+      std::cout << "Error: '" << name << "' is " << (expected ? "missing" : "not expected")
+                << ".\n";
+      ++failures;
+    }
+  if (!failures)
+    std::cout << "Success: Every conditional declaration is resolved as expected.\n";
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,73 @@
+﻿// Copyright (c) 2021 Cvelth <cvelth.mail@gmail.com>
+// SPDX-License-Identifier: MIT
+
+// Parses and generates two different fixtures on two threads at once, several times over, and
+// compares every output with the one of a sequential run. Build it with '-fsanitize=thread' to
+// check the concurrent calls for data races as well.
+
+#include <array>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "emitter.hpp"
+#include "generator.hpp"
+
+static constexpr size_t round_count = 4;
+
+static std::filesystem::path const directory = VMA_XML_TEST_FIXTURE;
+static std::filesystem::path const allocations = directory / "allocations";
+static std::vector<std::filesystem::path> const allocations_headers = {
+  allocations / "allocations.h"
+};
+static std::vector<std::filesystem::path> const preprocessor_headers = {
+  directory / "preprocessor.h"
+};
+
+// The json output of one of the fixtures, 'std::nullopt' if it could not be parsed.
+static std::optional<std::string> generate(size_t fixture) {
+  auto api = fixture == 0
+               ? vkma_xml::parse({ .xml_directory = allocations,
+                                   .header_files = allocations_headers })
+               : vkma_xml::parse_headers({ .xml_directory = directory,
+                                           .header_files = preprocessor_headers });
+  if (!api)
+    return std::nullopt;
+  vkma_xml::detail::json_emitter_t emitter;
+  if (!vkma_xml::generate(*api, { &emitter }, {}))
+    return std::nullopt;
+  return emitter.output;
+}
+
+int main() {
+  std::array<std::optional<std::string>, 2> expected = { generate(0), generate(1) };
+  if (!expected[0] || !expected[1]) {
+    std::cout << "Error: Unable to generate the fixtures sequentially.\n";
+    return 1;
+  }
+
+  std::array<std::vector<std::optional<std::string>>, 2> outputs;
+  {
+    std::vector<std::jthread> threads;
+    for (size_t fixture = 0; fixture < outputs.size(); ++fixture)
+      threads.emplace_back([&outputs, fixture] {
+        for (size_t round = 0; round < round_count; ++round)
+          outputs[fixture].emplace_back(generate(fixture));
+      });
+  }
+
+  int failures = 0;
+  for (size_t fixture = 0; fixture < outputs.size(); ++fixture)
+    for (size_t round = 0; round < round_count; ++round)
+      if (outputs[fixture][round] != expected[fixture]) {
+        std::cout << "Error: Fixture " << fixture << " generated concurrently (round " << round
+                  << ") differs from its sequential output.\n";
+        ++failures;
+      }
+  if (!failures)
+    std::cout << "Success: Concurrent calls generate what sequential ones do.\n";
+  return failures ? 1 : 0;
+}
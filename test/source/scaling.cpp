@@ -0,0 +1,127 @@
+﻿// Copyright (c) 2021 Cvelth <cvelth.mail@gmail.com>
+// SPDX-License-Identifier: MIT
+
+// Times the typename and whitespace kernels on adversarial inputs (long pointer and qualifier
+// chains, long whitespace runs) of 1x, 10x and 100x the size. Each step has to stay well below
+// the 100x growth of a quadratic kernel, or the test fails. Runs shorter than a few milliseconds
+// are repeated and averaged, so that even the 1x ones are not down to timer noise.
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "generator.hpp"
+
+// Linear growth is 10x a step, quadratic is 100x. The rest is room for caches and timer noise.
+static constexpr double growth_bound = 30;
+static constexpr size_t base_size = 1000;
+
+static constexpr size_t sample_count = 3;
+static constexpr std::chrono::milliseconds sample_duration{ 20 };
+
+// The seconds a single run takes: the best of a few samples, so that a preempted one does not
+// count, each of them repeating the run for at least 'sample_duration'.
+static double measure(std::function<void()> const &run) {
+  double best = 0;
+  for (size_t i = 0; i < sample_count; ++i) {
+    size_t repeats = 0;
+    auto start = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed;
+    do {
+      run();
+      ++repeats;
+      elapsed = std::chrono::steady_clock::now() - start;
+    } while (elapsed < sample_duration);
+    double seconds = elapsed.count() / repeats;
+    best = i ? std::min(best, seconds) : seconds;
+  }
+  return best;
+}
+
+static std::string pointer_chain(size_t size, std::string_view name = "VkbType") {
+  std::string output;
+  for (size_t i = 0; i < size; ++i)
+    output += "const * ";
+  output += name;
+  for (size_t i = 0; i < size; ++i)
+    output += i % 2 ? " *" : " const";
+  return output;
+}
+
+static std::filesystem::path const header = std::filesystem::temp_directory_path()
+                                            / "vkma_xml_scaling.h";
+
+struct kernel_t {
+  std::string_view name;
+  // Prepares an input of 'size' units and returns what parses it.
+  std::function<std::function<void()>(size_t size)> prepare;
+};
+static std::vector<kernel_t> const kernels = {
+  { "make_typename",
+    [](size_t size) {
+      // Typenames are interned, so every run gets a name of its own. Making it is linear too.
+      auto chain = pointer_chain(size, "VkbType");
+      auto name_end = chain.find("VkbType") + 7;
+      return [chain = std::move(chain), name_end, run = size_t(0)]() mutable {
+        auto input = chain;
+        input.insert(name_end, std::to_string(run++));
+        vkma_xml::detail::decorated_typename_t{ std::move(input) };
+      };
+    } },
+  { "optimize",
+    [](size_t size) {
+      auto document = std::make_shared<pugi::xml_document>();
+      auto define = document->append_child("memberdef");
+      define.append_child("name").append_child(pugi::node_pcdata).set_value("VKB_VALUE");
+      auto value = "(1" + std::string(size * 8, '\n') + std::string(size * 8, ' ') + "| 2)";
+      define.append_child("initializer").append_child(pugi::node_pcdata).set_value(value.c_str());
+      return [document, define] { vkma_xml::detail::api_t::load_define(define); };
+    } },
+  { "header whitespace",
+    [](size_t size) {
+      std::ofstream(header) << "typedef struct VkbChain {\n  " << pointer_chain(size) << ' '
+                            << std::string(size * 8, ' ') << "member;\n} VkbChain;\n";
+      return [] { vkma_xml::parse_headers({ .xml_directory = {}, .header_files = { header } }); };
+    } },
+};
+
+int main() {
+  // The header frontend reports every parse.
+  std::ostringstream log;
+  auto *output = std::cout.rdbuf(log.rdbuf());
+  std::vector<std::string> failures;
+  std::vector<std::string> results;
+  for (auto const &kernel : kernels) {
+    std::ostringstream result;
+    result << kernel.name << ':';
+    double previous = 0;
+    for (size_t scale : { 1, 10, 100 }) {
+      double seconds = measure(kernel.prepare(base_size * scale));
+      result << ' ' << scale << "x " << seconds << 's';
+      if (previous > 0 && seconds / previous > growth_bound)
+        failures.emplace_back(std::string(kernel.name) + " grows by "
+                              + std::to_string(seconds / previous) + " from "
+                              + std::to_string(scale / 10) + "x to " + std::to_string(scale)
+                              + "x.");
+      previous = seconds;
+    }
+    results.emplace_back(result.str());
+  }
+  std::cout.rdbuf(output);
+  std::filesystem::remove(header);
+
+  for (auto const &result : results)
+    std::cout << result << '\n';
+  for (auto const &failure : failures)
+    std::cout << "Error: " << failure << '\n';
+  if (failures.empty())
+    std::cout << "Success: Every kernel grows close to linearly.\n";
+  return failures.empty() ? 0 : 1;
+}
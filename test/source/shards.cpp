@@ -0,0 +1,76 @@
+﻿// Copyright (c) 2021 Cvelth <cvelth.mail@gmail.com>
+// SPDX-License-Identifier: MIT
+
+// Saves "test/fixture/allocations" in three shards and checks that they merge, in any order, into
+// what a single 'parse' generates, and that a missing, duplicated, stale or mismatched part makes
+// the whole set be rejected.
+
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "emitter.hpp"
+#include "generator.hpp"
+#include "shard.hpp"
+
+namespace detail = vkma_xml::detail;
+
+static std::filesystem::path const fixture =
+  std::filesystem::path(VMA_XML_TEST_FIXTURE) / "allocations";
+static vkma_xml::input const input{ .xml_directory = fixture,
+                                    .header_files = { fixture / "allocations.h" } };
+
+static std::optional<std::string> generate(std::optional<detail::api_t> api) {
+  if (!api)
+    return std::nullopt;
+  detail::json_emitter_t emitter;
+  if (!vkma_xml::generate(*api, { &emitter }, {}))
+    return std::nullopt;
+  return emitter.output;
+}
+
+int main() {
+  auto const directory = std::filesystem::temp_directory_path() / "vkma_xml_shards";
+  std::filesystem::create_directories(directory);
+  int failures = 0;
+  auto check = [&failures](bool condition, std::string_view description) {
+    if (!condition) {
+      std::cout << "Error: " << description << ".\n";
+      ++failures;
+    }
+  };
+  auto save = [&directory, &check](size_t index, size_t count, bool use_headers = false) {
+    auto path = directory
+                / ((use_headers ? "headers." : "") + std::to_string(index) + "-"
+                   + std::to_string(count) + ".shard");
+    detail::shard_t shard{ index, count };
+    auto api = use_headers ? detail::parse_headers({ &input }, shard)
+                           : detail::parse({ &input }, shard);
+    check(api && vkma_xml::save_shard(*api, path), "Unable to save a shard");
+    return path;
+  };
+
+  auto const expected = generate(detail::parse({ &input }));
+  check(expected.has_value(), "Unable to generate the fixture");
+  std::vector<std::filesystem::path> const parts = { save(0, 3), save(1, 3), save(2, 3) };
+  check(generate(vkma_xml::merge_shards(parts)) == expected,
+        "The merged shards generate something else than a single parse");
+  check(generate(vkma_xml::merge_shards({ parts[2], parts[0], parts[1] })) == expected,
+        "Reordered shards generate something else than a single parse");
+
+  check(!vkma_xml::merge_shards({ parts[0], parts[2] }), "A set with a missing part is merged");
+  check(!vkma_xml::merge_shards({ parts[0], parts[0], parts[2] }),
+        "A set with a duplicated part is merged");
+  check(!vkma_xml::merge_shards({ parts[0], save(1, 2) }),
+        "A part of a set of another size is merged");
+  check(!vkma_xml::merge_shards({ parts[0], save(1, 3, true), parts[2] }),
+        "A part parsed from other inputs is merged");
+
+  std::filesystem::remove_all(directory);
+  if (!failures)
+    std::cout << "Success: Only complete sets of shards are merged, in any order.\n";
+  return failures ? 1 : 0;
+}
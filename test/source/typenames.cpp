@@ -0,0 +1,64 @@
+﻿// Copyright (c) 2021 Cvelth <cvelth.mail@gmail.com>
+// SPDX-License-Identifier: MIT
+
+// Generates two apis one after the other, each with a typename table of its own, through the
+// same json emitter and checks that the second output does not reuse anything rendered for the
+// first one. Then checks that a type outlives the api it was made for.
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "emitter.hpp"
+#include "generator.hpp"
+
+namespace detail = vkma_xml::detail;
+
+// A struct with a single member of 'type'.
+static detail::api_t make_api(std::string type, std::string base_type) {
+  detail::api_t api;
+  std::vector<detail::variable_t> members;
+  members.emplace_back("value", detail::decorated_typename_t(std::move(type)));
+  api.add("VkbValue", detail::type_t{ detail::type::structure{ std::move(members) },
+                                      detail::type_tag::core });
+  api.add(std::move(base_type), detail::type_t{ detail::type::base{}, detail::type_tag::helper });
+  return api;
+}
+
+int main() {
+  int failures = 0;
+  auto check = [&failures](bool condition, std::string_view description) {
+    if (!condition) {
+      std::cout << "Error: " << description << ".\n";
+      ++failures;
+    }
+  };
+
+  detail::json_emitter_t reused;
+  {
+    auto api = make_api("uint32_t", "uint32_t");
+    vkma_xml::generate(api, { &reused }, {});
+  } // The table goes with the api: the ids of the next one start over.
+  {
+    auto api = make_api("float const *", "float");
+    vkma_xml::generate(api, { &reused }, {});
+    detail::json_emitter_t fresh;
+    vkma_xml::generate(api, { &fresh }, {});
+    check(fresh.output.find("float") != std::string::npos, "The type is missing from the output");
+    check(reused.output == fresh.output, "A reused emitter renders a stale type");
+  }
+
+  detail::decorated_typename_t kept;
+  {
+    auto api = make_api("VkbKept const *", "VkbKept");
+    auto const &state = api.registry.find("VkbValue")->second.state;
+    kept = std::get<detail::type::structure>(state).members->front().type;
+  }
+  check(kept.name() == "VkbKept" && kept.postfix() == "const *",
+        "A type does not outlive its api");
+
+  if (!failures)
+    std::cout << "Success: Every type is rendered from the table it belongs to.\n";
+  return failures ? 1 : 0;
+}